@@ -0,0 +1,695 @@
+#pragma once
+
+#include "rb_tree.hpp"
+
+#include <type_traits>
+#include <utility>
+#include <iterator>
+#include <memory>
+#include <algorithm>
+#include <new>
+#include <vector>
+
+#include <cassert>
+#include <cstddef>
+
+// B+-tree map with stable iterators: a cache-conscious alternative to rb_tree::arena_map for large maps (e.g. the beachline of millions of sites)
+// copies of keys are stored contiguously in wide nodes, so a descent visits about log(n) / log(order / 2) nodes instead of log2(n) scattered ones
+// elements are in slots, which never move: an iterator is a pointer to a slot, slots are linked in order (increment is O(1)),
+// a leaf refers to its slots and every slot refers back to its leaf (it is updated, when the slot moves to another leaf)
+// a separator of an internal node is a copy of the last key in the subtree on its left, so every key in nodes is a key of a present element:
+// there are no stale separators, which matters for comparators ordering only the present elements (as the one of the beachline does)
+// keys should be trivially copyable, slots and nodes are carved from blocks, which are kept by reset() for reuse
+namespace b_tree
+{
+
+using rb_tree::pair;
+using rb_tree::range;
+
+struct slot_base
+{
+
+    slot_base * prev;
+    slot_base * next;
+
+};
+
+template< typename type, typename slot >
+struct tree_iterator
+{
+
+    using value_type = type;
+    using reference = type &;
+    using pointer = type *;
+
+    using iterator_category = std::bidirectional_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+
+    slot_base * p = nullptr;
+
+    pointer operator -> () const noexcept { return static_cast< slot * >(p)->pointer(); }
+    reference operator * () const noexcept { return *operator -> (); }
+
+    tree_iterator & operator ++ () noexcept { p = p->next; return *this; }
+    const tree_iterator operator ++ (int) noexcept { return {std::exchange(p, p->next)}; }
+
+    tree_iterator & operator -- () noexcept { p = p->prev; return *this; }
+    const tree_iterator operator -- (int) noexcept { return {std::exchange(p, p->prev)}; }
+
+    bool operator == (const tree_iterator it) const noexcept { return p == it.p; }
+    bool operator != (const tree_iterator it) const noexcept { return !operator == (it); }
+
+    operator tree_iterator< const type, slot > () const { return {p}; }
+
+};
+
+// objects are carved from blocks, which grow geometrically and are released all at once by clear()
+template< typename type >
+struct pool
+{
+
+    using size_type = std::size_t;
+
+    static constexpr size_type min_block_size = 64;
+
+    // get() does not throw after it
+    void prepare(const size_type n)
+    {
+        if (free_.size() < n) {
+            add_block(std::max({capacity_, min_block_size, n - free_.size()}));
+        }
+    }
+
+    type * get()
+    {
+        prepare(1);
+        type * const p = free_.back();
+        free_.pop_back();
+        return p;
+    }
+
+    void put(type * const p) noexcept
+    {
+        free_.push_back(p); // capacity of free_ is reserved up to the number of objects
+    }
+
+    void reserve(const size_type n)
+    {
+        if (capacity_ < n) {
+            add_block(n - capacity_);
+        }
+    }
+
+    // all the objects are free
+    void reset() noexcept
+    {
+        free_.clear();
+        for (auto b = blocks_.rbegin(); b != blocks_.rend(); ++b) {
+            for (size_type i = b->size; 0 < i; --i) {
+                put(&b->objects[i - 1]);
+            }
+        }
+    }
+
+    void clear() noexcept
+    {
+        blocks_ = std::vector< block >{};
+        free_ = std::vector< type * >{};
+        capacity_ = 0;
+    }
+
+private :
+
+    struct block
+    {
+
+        std::unique_ptr< type[] > objects;
+        size_type size;
+
+    };
+
+    std::vector< block > blocks_;
+    std::vector< type * > free_;
+    size_type capacity_ = 0;
+
+    void add_block(const size_type n)
+    {
+        free_.reserve(capacity_ + n);
+        blocks_.push_back({std::make_unique< type[] >(n), n});
+        capacity_ += n;
+        for (size_type i = n; 0 < i; --i) { // objects are taken in the order of addresses
+            put(&blocks_.back().objects[i - 1]);
+        }
+    }
+
+};
+
+template< typename key_type,
+          typename mapped_type,
+          typename compare = std::less< key_type >,
+          std::size_t order = 16 >
+struct map
+{
+
+    static_assert(!(order < 4), "halves of a split node should have at least two entries");
+    static_assert(std::is_trivially_copyable< key_type >::value, "keys are copied into nodes");
+
+    using size_type = std::size_t;
+    using value_type = pair< key_type const, mapped_type >;
+    using compare_type = compare;
+
+private :
+
+    struct node;
+
+    struct slot
+            : slot_base
+    {
+
+        node * leaf;
+        union { value_type value; };
+
+        slot() noexcept { ; }
+
+        slot(const slot &) = delete;
+        slot(slot &&) = delete;
+        void operator = (const slot &) = delete;
+        void operator = (slot &&) = delete;
+
+        ~slot() { ; }
+
+        value_type * pointer() noexcept { return &value; }
+
+    };
+
+    // a leaf holds size elements: keys[i] is the key of slots[i]
+    // an internal node holds size children: keys[i] is the last key in the subtree of children[i] (for i + 1 < size)
+    struct node
+    {
+
+        node * parent;
+        size_type size;
+        bool leaf;
+
+        union { key_type keys[order]; };
+        union
+        {
+            slot * slots[order];
+            node * children[order];
+        };
+
+        node() noexcept { ; }
+
+        node(const node &) = delete;
+        node(node &&) = delete;
+        void operator = (const node &) = delete;
+        void operator = (node &&) = delete;
+
+        ~node() { ; }
+
+        const key_type & key(const size_type i) const noexcept { return *std::launder(&keys[i]); }
+
+        void set_key(const size_type i, const key_type & k) noexcept { ::new (&keys[i]) key_type(k); }
+
+        // [l, r) to [l + d, r + d) of keys
+        void shift_keys(const size_type l, const size_type r, const std::ptrdiff_t d) noexcept
+        {
+            if (d < 0) {
+                for (size_type i = l; i < r; ++i) {
+                    set_key(size_type(std::ptrdiff_t(i) + d), key(i));
+                }
+            } else {
+                for (size_type i = r; l < i; --i) {
+                    set_key(size_type(std::ptrdiff_t(i - 1) + d), key(i - 1));
+                }
+            }
+        }
+
+    };
+
+    static constexpr size_type half = order / 2; // lower bound of sizes of nodes, except the root
+
+    compare_type c;
+
+    pool< slot > slots_;
+    pool< node > nodes_;
+
+    slot_base h{&h, &h};
+    node * root_ = nullptr;
+    size_type depth_ = 0;
+    size_type s = 0;
+
+    static slot * to_slot(slot_base * const x) noexcept { return static_cast< slot * >(x); }
+
+    static size_type index(const node * const x, const slot_base * const y) noexcept
+    {
+        assert(x->leaf);
+        const auto i = size_type(std::find(x->slots, x->slots + x->size, y) - x->slots);
+        assert(i < x->size);
+        return i;
+    }
+
+    static size_type index(const node * const x, const node * const y) noexcept
+    {
+        assert(!x->leaf);
+        const auto i = size_type(std::find(x->children, x->children + x->size, y) - x->children);
+        assert(i < x->size);
+        return i;
+    }
+
+    static const key_type & last_key(const node * const x) noexcept
+    {
+        assert(x->leaf);
+        return x->key(x->size - 1);
+    }
+
+    node * make_node(const bool leaf, node * const parent) noexcept
+    {
+        node * const x = nodes_.get(); // prepared
+        x->parent = parent;
+        x->size = 0;
+        x->leaf = leaf;
+        return x;
+    }
+
+    // first i in [l, r), such that !c(x->key(i), k)
+    template< typename K, typename ...P >
+    size_type partition(const node * const x, size_type l, size_type r, const K & k, P &... p) const
+    {
+        while (l < r) {
+            const size_type m = l + (r - l) / 2;
+            if (c(x->key(m), k, p...)) {
+                l = m + 1;
+            } else {
+                r = m;
+            }
+        }
+        return l;
+    }
+
+    // y is the new right sibling of x, k is the new last key in the subtree of x
+    void insert_child(node * const x, node * const y, const key_type & k) noexcept
+    {
+        node * p = x->parent;
+        if (!p) {
+            p = make_node(false, nullptr);
+            p->children[0] = x;
+            p->children[1] = y;
+            p->set_key(0, k);
+            p->size = 2;
+            x->parent = y->parent = p;
+            root_ = p;
+            ++depth_;
+            return;
+        }
+        if (p->size == order) {
+            split(p);
+            p = x->parent;
+        }
+        const size_type i = index(p, x);
+        std::copy_backward(p->children + i + 1, p->children + p->size, p->children + p->size + 1);
+        p->shift_keys(i, p->size - 1, +1);
+        p->children[i + 1] = y;
+        p->set_key(i, k);
+        y->parent = p;
+        ++p->size;
+    }
+
+    // x keeps the left half, the right half goes to a new node
+    node * split(node * const x) noexcept
+    {
+        assert(x->size == order);
+        node * const y = make_node(x->leaf, x->parent);
+        const size_type m = half;
+        y->size = order - m;
+        x->size = m;
+        if (x->leaf) {
+            for (size_type i = m; i < order; ++i) {
+                y->slots[i - m] = x->slots[i];
+                y->set_key(i - m, x->key(i));
+                x->slots[i]->leaf = y;
+            }
+        } else {
+            for (size_type i = m; i < order; ++i) {
+                y->children[i - m] = x->children[i];
+                x->children[i]->parent = y;
+            }
+            for (size_type i = m; i + 1 < order; ++i) {
+                y->set_key(i - m, x->key(i));
+            }
+        }
+        insert_child(x, y, x->key(m - 1));
+        return y;
+    }
+
+    void insert_slot(node * x, size_type i, slot * const y) noexcept
+    {
+        if (x->size == order) {
+            node * const z = split(x);
+            if (!(i < x->size)) { // after the last element of x goes to z: separator of x stays
+                i -= x->size;
+                x = z;
+            }
+        }
+        std::copy_backward(x->slots + i, x->slots + x->size, x->slots + x->size + 1);
+        x->shift_keys(i, x->size, +1);
+        x->slots[i] = y;
+        x->set_key(i, y->value.k);
+        y->leaf = x;
+        ++x->size;
+    }
+
+    // the last key of the leaf changed
+    void update_separator(node * x) noexcept
+    {
+        const key_type & k = last_key(x);
+        while (node * const p = x->parent) {
+            const size_type i = index(p, x);
+            if (i + 1 < p->size) {
+                p->set_key(i, k);
+                return;
+            }
+            x = p;
+        }
+    }
+
+    // x is children[i] of p
+    void borrow_left(node * const p, const size_type i) noexcept
+    {
+        node * const l = p->children[i - 1];
+        node * const x = p->children[i];
+        if (x->leaf) {
+            std::copy_backward(x->slots, x->slots + x->size, x->slots + x->size + 1);
+            x->shift_keys(0, x->size, +1);
+            x->slots[0] = l->slots[l->size - 1];
+            x->set_key(0, l->key(l->size - 1));
+            x->slots[0]->leaf = x;
+            --l->size;
+            p->set_key(i - 1, last_key(l));
+        } else {
+            std::copy_backward(x->children, x->children + x->size, x->children + x->size + 1);
+            x->shift_keys(0, x->size - 1, +1);
+            x->children[0] = l->children[l->size - 1];
+            x->set_key(0, p->key(i - 1));
+            x->children[0]->parent = x;
+            p->set_key(i - 1, l->key(l->size - 2));
+            --l->size;
+        }
+        ++x->size;
+    }
+
+    void borrow_right(node * const p, const size_type i) noexcept
+    {
+        node * const x = p->children[i];
+        node * const r = p->children[i + 1];
+        if (x->leaf) {
+            x->slots[x->size] = r->slots[0];
+            x->set_key(x->size, r->key(0));
+            x->slots[x->size]->leaf = x;
+            ++x->size;
+            p->set_key(i, last_key(x));
+            std::copy(r->slots + 1, r->slots + r->size, r->slots);
+            r->shift_keys(1, r->size, -1);
+        } else {
+            x->children[x->size] = r->children[0];
+            x->set_key(x->size - 1, p->key(i));
+            x->children[x->size]->parent = x;
+            ++x->size;
+            p->set_key(i, r->key(0));
+            std::copy(r->children + 1, r->children + r->size, r->children);
+            r->shift_keys(1, r->size - 1, -1);
+        }
+        --r->size;
+    }
+
+    // children[i + 1] of p is appended to children[i]
+    void merge(node * const p, const size_type i) noexcept
+    {
+        node * const l = p->children[i];
+        node * const r = p->children[i + 1];
+        assert(!(order < l->size + r->size));
+        if (l->leaf) {
+            for (size_type j = 0; j < r->size; ++j) {
+                l->slots[l->size + j] = r->slots[j];
+                l->set_key(l->size + j, r->key(j));
+                r->slots[j]->leaf = l;
+            }
+        } else {
+            l->set_key(l->size - 1, p->key(i));
+            for (size_type j = 0; j < r->size; ++j) {
+                l->children[l->size + j] = r->children[j];
+                r->children[j]->parent = l;
+            }
+            for (size_type j = 0; j + 1 < r->size; ++j) {
+                l->set_key(l->size + j, r->key(j));
+            }
+        }
+        l->size += r->size;
+        std::copy(p->children + i + 2, p->children + p->size, p->children + i + 1);
+        p->shift_keys(i + 1, p->size - 1, -1);
+        --p->size;
+        nodes_.put(r);
+    }
+
+    void rebalance(node * x) noexcept
+    {
+        while ((x != root_) && (x->size < half)) {
+            node * const p = x->parent;
+            const size_type i = index(p, x);
+            if ((0 < i) && (half < p->children[i - 1]->size)) {
+                borrow_left(p, i);
+                return;
+            }
+            if ((i + 1 < p->size) && (half < p->children[i + 1]->size)) {
+                borrow_right(p, i);
+                return;
+            }
+            merge(p, (0 < i) ? (i - 1) : i);
+            x = p;
+        }
+        if (!root_->leaf && (root_->size == 1)) {
+            node * const r = std::exchange(root_, root_->children[0]);
+            root_->parent = nullptr;
+            nodes_.put(r);
+            --depth_;
+        }
+    }
+
+    void destroy_values() noexcept
+    {
+        if constexpr (!std::is_trivially_destructible< value_type >::value) {
+            for (slot_base * x = h.next; x != &h; x = x->next) {
+                to_slot(x)->value.~value_type();
+            }
+        }
+    }
+
+public :
+
+    map() = default;
+
+    map(const map &) = delete;
+    map(map &&) = delete;
+    void operator = (const map &) = delete;
+    void operator = (map &&) = delete;
+
+    map(const compare_type & comp)
+        : c{comp}
+    { ; }
+
+    // blocks are allocated by new, other allocators are not supported
+    template< typename type >
+    map(const compare_type & comp, const std::allocator< type > &)
+        : c{comp}
+    { ; }
+
+    size_type size() const noexcept { return s; }
+
+    bool empty() const noexcept { return (0 == s); }
+
+    // n / half leaves at most, a fraction of them of internal nodes
+    void reserve(const size_type n)
+    {
+        slots_.reserve(n);
+        nodes_.reserve(n / (half - 1) + 2);
+    }
+
+    // memory taken by reserve(n) of an empty map, with pointers of free lists
+    static constexpr size_type reserved_bytes(const size_type n) noexcept
+    {
+        return n * (sizeof(slot) + sizeof(slot *)) + (n / (half - 1) + 2) * (sizeof(node) + sizeof(node *));
+    }
+
+    void shrink_to_fit() noexcept
+    {
+        if (empty()) {
+            slots_.clear();
+            nodes_.clear();
+        }
+    }
+
+    void clear() noexcept
+    {
+        reset();
+        shrink_to_fit();
+    }
+
+    // as clear(), but all the slots and nodes are kept for reuse, so refilling the map up to the former size does not allocate
+    void reset() noexcept
+    {
+        destroy_values();
+        h = {&h, &h};
+        root_ = nullptr;
+        depth_ = 0;
+        s = 0;
+        slots_.reset();
+        nodes_.reset();
+    }
+
+    ~map() noexcept
+    {
+        clear();
+    }
+
+    using iterator = tree_iterator< value_type, slot >;
+    using const_iterator = tree_iterator< const value_type, slot >;
+
+    iterator begin() { return {h.next}; }
+    iterator end() { return {&h}; }
+
+    const_iterator begin() const { return {h.next}; }
+    const_iterator end() const { return {const_cast< slot_base * >(&h)}; }
+
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    // v is inserted right before the hint, its order relative to neighbours is not checked
+    template< typename K = value_type >
+    iterator
+    force_insert(const const_iterator hint, K && v)
+    {
+        slot * const y = slots_.get();
+        try {
+            nodes_.prepare(depth_ + 1);
+            ::new (y->pointer()) value_type(std::forward< K >(v));
+        } catch (...) {
+            slots_.put(y);
+            throw;
+        }
+        slot_base * const next = hint.p;
+        if (!root_) {
+            assert(next == &h);
+            root_ = make_node(true, nullptr);
+            depth_ = 1;
+            insert_slot(root_, 0, y);
+        } else if (next == &h) {
+            node * const x = to_slot(h.prev)->leaf;
+            insert_slot(x, x->size, y);
+        } else {
+            node * const x = to_slot(next)->leaf;
+            insert_slot(x, index(x, next), y);
+        }
+        y->prev = next->prev;
+        y->next = next;
+        next->prev->next = y;
+        next->prev = y;
+        ++s;
+        return {y};
+    }
+
+    iterator
+    erase(const const_iterator it) noexcept
+    {
+        slot * const y = to_slot(it.p);
+        const iterator next{y->next};
+        node * const x = y->leaf;
+        const size_type i = index(x, y);
+        std::copy(x->slots + i + 1, x->slots + x->size, x->slots + i);
+        x->shift_keys(i + 1, x->size, -1);
+        --x->size;
+        y->prev->next = y->next;
+        y->next->prev = y->prev;
+        y->value.~value_type();
+        slots_.put(y);
+        if (--s == 0) {
+            assert(x == root_);
+            nodes_.put(std::exchange(root_, nullptr));
+            depth_ = 0;
+            return next;
+        }
+        assert(0 < x->size);
+        if (i == x->size) {
+            update_separator(x);
+        }
+        rebalance(x);
+        return next;
+    }
+
+    template< typename K = value_type, typename ...P >
+    iterator
+    lower_bound(const K & k, P &... p)
+    {
+        if (!root_) {
+            return end();
+        }
+        const node * x = root_;
+        while (!x->leaf) {
+            x = x->children[partition(x, 0, x->size - 1, k, p...)];
+        }
+        const size_type i = partition(x, 0, x->size, k, p...);
+        if (i < x->size) {
+            return {x->slots[i]};
+        }
+        return {x->slots[i - 1]->next}; // all are less only in the rightmost leaf
+    }
+
+    // finger search: the leaf of the hint is searched, if it brackets the key, else the whole tree is,
+    // so it takes 2 + log2(order) comparisons for near results and 2 more, than lower_bound(), for far ones
+    template< typename K = value_type, typename ...P >
+    iterator
+    lower_bound_from(const const_iterator hint, const K & k, P &... p)
+    {
+        if (hint.p == &h) {
+            return lower_bound(k, p...);
+        }
+        const node * const x = to_slot(hint.p)->leaf;
+        const size_type n = x->size;
+        if (!c(x->key(0), k, p...)) {
+            if (x->slots[0]->prev == &h) {
+                return {x->slots[0]};
+            }
+        } else if (!c(x->key(n - 1), k, p...)) {
+            return {x->slots[partition(x, 1, n - 1, k, p...)]};
+        } else if (x->slots[n - 1]->next == &h) {
+            return end();
+        }
+        return lower_bound(k, p...);
+    }
+
+    template< typename K = value_type, typename ...P >
+    range< iterator >
+    equal_range(const K & k, P &... p)
+    {
+        auto l = lower_bound(k, p...);
+        auto r = l;
+        while ((r != end()) && !c(k, r->k, p...)) {
+            ++r;
+        }
+        return {l, r};
+    }
+
+    template< typename K = value_type, typename ...P >
+    range< iterator >
+    equal_range_from(const const_iterator hint, const K & k, P &... p)
+    {
+        auto l = lower_bound_from(hint, k, p...);
+        auto r = l;
+        while ((r != end()) && !c(k, r->k, p...)) {
+            ++r;
+        }
+        return {l, r};
+    }
+
+};
+
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "sweepline.hpp"
+#include "thread_pool.hpp"
+
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include <cassert>
+#include <cstddef>
+
+// Many independent diagrams at once (e.g. one per tile): jobs are ranges of sorted sites.
+// Every worker of the pool keeps its own sweepline, so its pools stay allocated between jobs and between calls.
+// Jobs are taken by free workers one at a time, the largest first, then small ones fill the gaps at the end.
+// Diagrams are gathered into flat vertices_ and edges_ in order of jobs: diagram j is [offsets_[j].vertex, offsets_[j + 1].vertex)
+// of vertices_ and [offsets_[j].edge, offsets_[j + 1].edge) of edges_, ends of its edges are indices into vertices_ (inf for rays).
+template< typename site,
+          typename point = typename std::iterator_traits< site >::value_type,
+          typename value_type = decltype(std::declval< point >().x),
+          typename event_queue = tree_event_queue >
+struct batch_sweepline
+{
+
+    using sweepline_type = sweepline< site, point, value_type, event_queue >;
+
+    using size_type = typename sweepline_type::size_type;
+    using vertex = typename sweepline_type::vertex;
+    using vertices = typename sweepline_type::vertices;
+    using pvertex = typename sweepline_type::pvertex;
+    using edge = typename sweepline_type::edge;
+    using edges = typename sweepline_type::edges;
+    using pedge = typename sweepline_type::pedge;
+
+    struct offset
+    {
+
+        pvertex vertex;
+        pedge edge;
+
+    };
+
+    batch_sweepline(value_type eps, thread_pool & _pool)
+        : eps_{std::move(eps)}
+        , pool_(_pool)
+        , workers_(_pool.size())
+    {
+        assert(!(eps_ < value_type(0)));
+    }
+
+    vertices vertices_;
+    const pvertex inf = std::numeric_limits< pvertex >::max();
+    edges edges_;
+    std::vector< offset > offsets_; // size() + 1
+
+    size_type size() const { return jobs_.size(); }
+
+    // std::cbegin and std::cend of every range of [first, last) are sites, which should be sorted
+    template< typename iterator >
+    void operator () (const iterator first, const iterator last)
+    {
+        jobs_.clear();
+        for (auto r = first; r != last; ++r) {
+            const site l = std::cbegin(*r);
+            const site h = std::cend(*r);
+            assert(std::is_sorted(l, h));
+            jobs_.push_back({l, h, size_type(std::distance(l, h)), 0, 0, 0, 0, 0});
+        }
+        const size_type n = jobs_.size();
+        order_.resize(n);
+        for (size_type j = 0; j < n; ++j) {
+            order_[j] = j;
+        }
+        std::stable_sort(std::begin(order_), std::end(order_), [&] (const size_type l, const size_type r) { return jobs_[r].size < jobs_[l].size; });
+        for (worker & worker_ : workers_) {
+            worker_.vertices_.clear();
+            worker_.edges_.clear();
+        }
+        pool_.parallel_for(n, [&] (const size_type i, const size_type w) { sweep(jobs_[order_[i]], w); });
+        offsets_.resize(n + 1);
+        offsets_.front() = {0, 0};
+        for (size_type j = 0; j < n; ++j) {
+            const job & job_ = jobs_[j];
+            offsets_[j + 1] = {offsets_[j].vertex + job_.vertices, offsets_[j].edge + job_.edges};
+        }
+        vertices_.resize(offsets_.back().vertex);
+        edges_.resize(offsets_.back().edge);
+        pool_.parallel_for(n, [&] (const size_type j, size_type) { gather(j); });
+    }
+
+    // releases diagrams and pools of the workers
+    void clear()
+    {
+        vertices_ = vertices{}; // not = {}, which keeps capacity
+        edges_ = edges{};
+        offsets_ = std::vector< offset >{};
+        jobs_ = std::vector< job >{};
+        order_ = std::vector< size_type >{};
+        for (worker & worker_ : workers_) {
+            worker_ = {};
+        }
+    }
+
+private :
+
+    const value_type eps_;
+    thread_pool & pool_;
+
+    struct job
+    {
+
+        site first, last;
+        size_type size;
+
+        size_type worker; // which swept it
+        pvertex vertex; // in buffers of the worker
+        pvertex vertices;
+        pedge edge;
+        pedge edges;
+
+    };
+
+    struct alignas(64) worker // no false sharing
+    {
+
+        std::unique_ptr< sweepline_type > sweepline_; // made on the first job
+        vertices vertices_;
+        edges edges_;
+
+    };
+
+    std::vector< job > jobs_;
+    std::vector< size_type > order_; // of jobs, largest first
+    std::vector< worker > workers_;
+
+    void sweep(job & _job, const size_type w)
+    {
+        worker & worker_ = workers_[w];
+        if (!worker_.sweepline_) {
+            worker_.sweepline_ = std::make_unique< sweepline_type >(eps_);
+        }
+        sweepline_type & sweepline_ = *worker_.sweepline_;
+        sweepline_.clear();
+        sweepline_(_job.first, _job.last);
+        _job.worker = w;
+        _job.vertex = pvertex(worker_.vertices_.size());
+        _job.vertices = pvertex(sweepline_.vertices_.size());
+        _job.edge = pedge(worker_.edges_.size());
+        _job.edges = pedge(sweepline_.edges_.size());
+        worker_.vertices_.insert(std::cend(worker_.vertices_), std::cbegin(sweepline_.vertices_), std::cend(sweepline_.vertices_));
+        worker_.edges_.insert(std::cend(worker_.edges_), std::cbegin(sweepline_.edges_), std::cend(sweepline_.edges_));
+    }
+
+    void gather(const size_type j)
+    {
+        const job & job_ = jobs_[j];
+        const worker & worker_ = workers_[job_.worker];
+        const offset & offset_ = offsets_[j];
+        const auto vfirst = std::next(std::cbegin(worker_.vertices_), std::ptrdiff_t(job_.vertex));
+        std::copy(vfirst, std::next(vfirst, std::ptrdiff_t(job_.vertices)), std::next(std::begin(vertices_), std::ptrdiff_t(offset_.vertex)));
+        const auto shift = [&] (const pvertex v) { return (v == inf) ? inf : (v + offset_.vertex); };
+        pedge e = offset_.edge;
+        for (pedge i = job_.edge; i < job_.edge + job_.edges; ++i) {
+            const edge & edge_ = worker_.edges_[i];
+            edges_[e++] = {edge_.l, edge_.r, shift(edge_.b), shift(edge_.e)};
+        }
+    }
+
+};
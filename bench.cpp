@@ -0,0 +1,376 @@
+#include "voronoi.hpp"
+
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include <string>
+#include <ostream>
+#include <istream>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <streambuf>
+#include <chrono>
+#include <atomic>
+#include <new>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+#include <sys/resource.h>
+
+// benchmark of generators of voronoi over sizes 10^k in [min, max]: every run is repeated with the same sites
+// median and 99th percentile of time, sites per second (of median), peak RSS and heap allocations are reported for each phase:
+// input (parsing of textual sites), sort, sweep, resweep (clear() and sweep of the same sites again, it should not allocate)
+// output (whole gnuplot script is written to nowhere) and dump (binary diagram is written to /dev/null)
+// usage: sweepline_bench [--min N] [--max N] [--repeats R] [--seed S] [--format csv|json] [--generators g,...] [--queues q,...]
+
+namespace
+{
+
+std::atomic< std::size_t > allocations{0};
+
+void * allocate(std::size_t size, const std::size_t alignment = alignof(std::max_align_t))
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    size = size ? size : 1;
+    void * const p = (alignment <= alignof(std::max_align_t)) ? std::malloc(size) : std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    if (!p) {
+        throw std::bad_alloc{};
+    }
+    return p;
+}
+
+}
+
+// all the replaceable forms are replaced as a set, so every delete matches its new (nothrow ones call these by default)
+void * operator new (const std::size_t size) { return allocate(size); }
+void * operator new [] (const std::size_t size) { return allocate(size); }
+void * operator new (const std::size_t size, const std::align_val_t alignment) { return allocate(size, std::size_t(alignment)); }
+void * operator new [] (const std::size_t size, const std::align_val_t alignment) { return allocate(size, std::size_t(alignment)); }
+
+void operator delete (void * const p) noexcept { std::free(p); }
+void operator delete [] (void * const p) noexcept { std::free(p); }
+void operator delete (void * const p, std::size_t) noexcept { std::free(p); }
+void operator delete [] (void * const p, std::size_t) noexcept { std::free(p); }
+void operator delete (void * const p, std::align_val_t) noexcept { std::free(p); }
+void operator delete [] (void * const p, std::align_val_t) noexcept { std::free(p); }
+void operator delete (void * const p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete [] (void * const p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+namespace
+{
+
+using value_type = double;
+using point = plane_point< value_type >;
+using size_type = std::size_t;
+using seed_type = typename voronoi< point >::seed_type;
+
+// discards everything, but formatting is performed
+struct null_buffer
+        : std::streambuf
+{
+
+protected :
+
+    int_type overflow(int_type c) override { return traits_type::not_eof(c); }
+    std::streamsize xsputn(const char *, std::streamsize n) override { return n; }
+
+};
+
+enum phase { input, sort, sweep, resweep, output, dump, phases };
+
+const char * const phase_names[phases] = {"input", "sort", "sweep", "resweep", "output", "dump"};
+
+// VmHWM is reset to current RSS by writing "5" to clear_refs (Linux 4.0+)
+// otherwise peak RSS of the process so far is reported
+void reset_peak_rss()
+{
+    std::ofstream{"/proc/self/clear_refs"} << "5";
+}
+
+size_type peak_rss() // KiB
+{
+    std::ifstream status_{"/proc/self/status"};
+    std::string line_;
+    while (std::getline(status_, line_)) {
+        if (line_.compare(0, 6, "VmHWM:") == 0) {
+            return size_type(std::strtoull(line_.c_str() + 6, nullptr, 10));
+        }
+    }
+    rusage usage_;
+    if (getrusage(RUSAGE_SELF, &usage_) != 0) {
+        return 0;
+    }
+    return size_type(usage_.ru_maxrss);
+}
+
+struct options
+{
+
+    size_type min_size = 1000;
+    size_type max_size = 1000000;
+    size_type repeats = 5;
+    seed_type seed = 3465238787838062301;
+    bool json = false;
+    std::vector< std::string > generators = {"ball", "square", "gauss", "rectangular_grid", "diagonal_grid", "hexagonal_grid", "triangular_grid"};
+    std::vector< std::string > queues = {"tree", "heap2", "heap4"};
+
+};
+
+// textual sites of the generator, grids are of nearest size
+bool generate(std::ostream & _out, const std::string & generator, const size_type N, const seed_type seed)
+{
+    null_buffer null_buffer_;
+    std::ostream log_{&null_buffer_};
+    voronoi< point > voronoi_{log_};
+    voronoi_.seed(seed);
+    _out.precision(std::numeric_limits< value_type >::max_digits10);
+    const auto side = [&] (const value_type density) // N ~ density * side^2
+    {
+        using std::sqrt;
+        return std::max(size_type(1), size_type(std::lround(sqrt(value_type(N) / density))));
+    };
+    if (generator == "ball") {
+        voronoi_.ball(_out, value_type(10000), N);
+    } else if (generator == "square") {
+        voronoi_.square(_out, value_type(10000), N);
+    } else if (generator == "gauss") {
+        voronoi_.gauss(_out, value_type(10000), N);
+    } else if (generator == "rectangular_grid") {
+        voronoi_.rectangular_grid(_out, side(value_type(4)));
+    } else if (generator == "diagonal_grid") {
+        voronoi_.diagonal_grid(_out, side(value_type(2)));
+    } else if (generator == "hexagonal_grid") {
+        voronoi_.hexagonal_grid(_out, side(value_type(2)));
+    } else if (generator == "triangular_grid") {
+        voronoi_.triangular_grid(_out, side(value_type(4)));
+    } else {
+        return false;
+    }
+    return true;
+}
+
+struct statistics
+{
+
+    double median, p99; // seconds
+    size_type rss;
+    size_type allocations; // the most of all the repeats
+
+};
+
+statistics summarize(std::vector< double > & _seconds, const size_type rss, const size_type _allocations)
+{
+    assert(!_seconds.empty());
+    std::sort(std::begin(_seconds), std::end(_seconds));
+    const size_type size = _seconds.size();
+    const auto p99 = size_type(std::ceil(0.99 * double(size))) - 1;
+    return {_seconds[(size - 1) / 2], _seconds[p99], rss, _allocations};
+}
+
+struct report
+{
+
+    std::ostream & out_;
+    const bool json;
+
+    bool empty = true;
+
+    report(std::ostream & _out, const bool _json)
+        : out_(_out)
+        , json(_json)
+    {
+        if (json) {
+            out_ << "[\n";
+        } else {
+            out_ << "generator,queue,size,sites,repeats,phase,median_us,p99_us,sites_per_s,peak_rss_kib,allocations\n";
+        }
+    }
+
+    ~report()
+    {
+        if (json) {
+            out_ << (empty ? "]\n" : "\n]\n");
+        }
+        out_ << std::flush;
+    }
+
+    void operator () (const std::string & generator, const std::string & queue,
+                      const size_type size, const size_type sites, const size_type repeats,
+                      const char * const phase_name, const statistics & statistics_)
+    {
+        const double median = statistics_.median * 1E6;
+        const double p99 = statistics_.p99 * 1E6;
+        const double rate = (0.0 < statistics_.median) ? (double(sites) / statistics_.median) : 0.0;
+        if (json) {
+            out_ << (empty ? "" : ",\n")
+                 << R"(  {"generator": ")" << generator
+                 << R"(", "queue": ")" << queue
+                 << R"(", "size": )" << size
+                 << R"(, "sites": )" << sites
+                 << R"(, "repeats": )" << repeats
+                 << R"(, "phase": ")" << phase_name
+                 << R"(", "median_us": )" << median
+                 << R"(, "p99_us": )" << p99
+                 << R"(, "sites_per_s": )" << rate
+                 << R"(, "peak_rss_kib": )" << statistics_.rss
+                 << R"(, "allocations": )" << statistics_.allocations
+                 << '}';
+        } else {
+            out_ << generator << ',' << queue << ',' << size << ',' << sites << ',' << repeats << ','
+                 << phase_name << ',' << median << ',' << p99 << ',' << rate << ',' << statistics_.rss << ',' << statistics_.allocations << '\n';
+        }
+        out_ << std::flush;
+        empty = false;
+    }
+
+};
+
+template< typename event_queue >
+void run(report & _report, const options & _options,
+         const std::string & generator, const std::string & queue,
+         const size_type size, const std::string & sites)
+{
+    using voronoi_type = voronoi< point, value_type, event_queue >;
+    using clock_type = std::chrono::steady_clock;
+    null_buffer null_buffer_;
+    std::ostream null_{&null_buffer_};
+    std::vector< double > seconds[phases];
+    size_type rss[phases] = {};
+    size_type counts[phases] = {};
+    size_type N = 0;
+    for (size_type r = 0; r < _options.repeats; ++r) {
+        voronoi_type voronoi_{null_};
+        voronoi_.output_limit = std::numeric_limits< size_type >::max();
+        std::istringstream in_{sites};
+        const auto measure = [&] (const phase _phase, const auto & f)
+        {
+            reset_peak_rss();
+            const size_type before = allocations.load(std::memory_order_relaxed);
+            const auto start = clock_type::now();
+            f();
+            const auto stop = clock_type::now();
+            counts[_phase] = std::max(counts[_phase], allocations.load(std::memory_order_relaxed) - before);
+            seconds[_phase].push_back(std::chrono::duration< double >(stop - start).count());
+            rss[_phase] = std::max(rss[_phase], peak_rss());
+        };
+        measure(input, [&] { in_ >> voronoi_; });
+        measure(sort, [&] { voronoi_.sort_sites(); });
+        measure(sweep, [&] { voronoi_.sweep(); });
+        measure(resweep, [&] { voronoi_.sweepline_.clear(); voronoi_.sweep(); });
+        measure(output, [&] { null_ << voronoi_; });
+        measure(dump, [&] { voronoi_.write("/dev/null"); });
+        N = voronoi_.size();
+    }
+    for (size_type p = 0; p < phases; ++p) {
+        _report(generator, queue, size, N, _options.repeats, phase_names[p], summarize(seconds[p], rss[p], counts[p]));
+    }
+}
+
+using runner = void (*)(report & _report, const options & _options,
+                        const std::string & generator, const std::string & queue,
+                        const size_type size, const std::string & sites);
+
+runner find_runner(const std::string & queue)
+{
+    if (queue == "tree") {
+        return run< tree_event_queue >;
+    } else if (queue == "heap2") {
+        return run< heap_event_queue< 2 > >;
+    } else if (queue == "heap4") {
+        return run< heap_event_queue< 4 > >;
+    } else {
+        return nullptr;
+    }
+}
+
+std::vector< std::string > split(const std::string & list)
+{
+    std::vector< std::string > items;
+    std::istringstream in_{list};
+    std::string item;
+    while (std::getline(in_, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(std::move(item));
+        }
+    }
+    return items;
+}
+
+bool parse(const int argc, char * argv[], options & _options)
+{
+    for (int i = 1; i < argc; ++i) {
+        if (!(i + 1 < argc)) {
+            return false;
+        }
+        const char * const name = argv[i];
+        const char * const value = argv[++i];
+        const auto number = [&] { return std::strtoull(value, nullptr, 10); };
+        if (std::strcmp(name, "--min") == 0) {
+            _options.min_size = size_type(number());
+        } else if (std::strcmp(name, "--max") == 0) {
+            _options.max_size = size_type(number());
+        } else if (std::strcmp(name, "--repeats") == 0) {
+            _options.repeats = size_type(number());
+        } else if (std::strcmp(name, "--seed") == 0) {
+            _options.seed = seed_type(number());
+        } else if (std::strcmp(name, "--format") == 0) {
+            if (std::strcmp(value, "json") == 0) {
+                _options.json = true;
+            } else if (std::strcmp(value, "csv") == 0) {
+                _options.json = false;
+            } else {
+                return false;
+            }
+        } else if (std::strcmp(name, "--generators") == 0) {
+            _options.generators = split(value);
+        } else if (std::strcmp(name, "--queues") == 0) {
+            _options.queues = split(value);
+        } else {
+            return false;
+        }
+    }
+    return (0 < _options.min_size) && !(_options.max_size < _options.min_size) && (0 < _options.repeats);
+}
+
+}
+
+int main(int argc, char * argv[])
+{
+    options options_;
+    if (!parse(argc, argv, options_)) {
+        std::cerr << "usage: " << argv[0] << " [--min N] [--max N] [--repeats R] [--seed S] [--format csv|json] [--generators g,...] [--queues tree,heap2,heap4]\n";
+        return EXIT_FAILURE;
+    }
+    for (const std::string & queue : options_.queues) {
+        if (!find_runner(queue)) {
+            std::cerr << "unknown event queue: " << queue << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+    report report_{std::cout, options_.json};
+    for (const std::string & generator : options_.generators) {
+        for (size_type size = options_.min_size; !(options_.max_size < size); size *= 10) {
+            std::ostringstream sites_;
+            if (!generate(sites_, generator, size, options_.seed)) {
+                std::cerr << "unknown generator: " << generator << '\n';
+                return EXIT_FAILURE;
+            }
+            const std::string sites = sites_.str();
+            for (const std::string & queue : options_.queues) {
+                find_runner(queue)(report_, options_, generator, queue, size, sites);
+            }
+            if (std::numeric_limits< size_type >::max() / 10 < size) {
+                break;
+            }
+        }
+    }
+    return EXIT_SUCCESS;
+}
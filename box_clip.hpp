@@ -0,0 +1,199 @@
+#pragma once
+
+#include "dcel.hpp"
+
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <vector>
+
+#include <cassert>
+#include <cstddef>
+#include <cmath>
+
+// Cells of the diagram clipped by the rectangle [vmin, vmax] into closed convex polygons in linear time over the DCEL.
+// Infinite parts of a cell are cut by a circle around the rectangle, which contains all finite vertices of the cell: ends of rays and lines
+// are put on the circle and the arc between them is replaced by chords of at most pi / 2, so that the lost segments are out of the rectangle.
+// Then the polygon is clipped by each of four sides of the rectangle in turn (Sutherland-Hodgman), corners of the rectangle become its vertices.
+// Polygon of cell c is [offsets_[c], offsets_[c + 1]) of points_ in CCW order (empty for cells out of the rectangle).
+// Buffers are reused between calls, nothing is allocated per edge or per cell once they are warm.
+template< typename site,
+          typename value_type = decltype(std::declval< typename std::iterator_traits< site >::value_type >().x) >
+struct box_clip
+{
+
+    using dcel_type = dcel< site, value_type >;
+    using size_type = typename dcel_type::size_type;
+    using pcell = typename dcel_type::pcell;
+    using phalf_edge = typename dcel_type::phalf_edge;
+    using vertex_point = typename dcel_type::vertex_point;
+
+    box_clip(const vertex_point & _vmin, const vertex_point & _vmax)
+        : vmin{_vmin}
+        , vmax{_vmax}
+        , center_{(vmin.x + vmax.x) / value_type(2), (vmin.y + vmax.y) / value_type(2)}
+        , R2_{((vmax.x - vmin.x) * (vmax.x - vmin.x) + (vmax.y - vmin.y) * (vmax.y - vmin.y)) / value_type(4)}
+    {
+        assert(!(vmax.x < vmin.x) && !(vmax.y < vmin.y));
+    }
+
+    const vertex_point vmin, vmax;
+
+    std::vector< vertex_point > points_;
+    std::vector< size_type > offsets_; // number of cells + 1
+
+    void operator () (const dcel_type & dcel_)
+    {
+        const size_type n = dcel_.cells_.size();
+        points_.clear();
+        offsets_.resize(n + 1);
+        offsets_.front() = 0;
+        for (pcell c = 0; c < n; ++c) {
+            clip_cell(dcel_, c);
+            points_.insert(std::cend(points_), std::cbegin(in_), std::cend(in_));
+            offsets_[c + 1] = points_.size();
+        }
+    }
+
+    // polygon of one cell in CCW order, valid until the next call: points_ and offsets_ are not touched,
+    // so threads of a parallel pass over cells can use one box_clip each
+    const std::vector< vertex_point > & clip_cell(const dcel_type & dcel_, const pcell c)
+    {
+        make_cell(dcel_, c);
+        clip(value_type(+1), value_type(0), -vmin.x);
+        clip(value_type(-1), value_type(0), +vmax.x);
+        clip(value_type(0), value_type(+1), -vmin.y);
+        clip(value_type(0), value_type(-1), +vmax.y);
+        return in_;
+    }
+
+private :
+
+    const vertex_point center_;
+    const value_type R2_; // squared half of the diagonal
+
+    std::vector< vertex_point > in_, out_;
+
+    value_type R_ = value_type(0); // of the circle for the current cell
+
+    value_type distance2(const vertex_point & p) const
+    {
+        const value_type dx = p.x - center_.x;
+        const value_type dy = p.y - center_.y;
+        return dx * dx + dy * dy;
+    }
+
+    // intersection with the circle of the ray from p inside of it in the direction (dx, dy)
+    vertex_point far_point(const vertex_point & p, const value_type dx, const value_type dy) const
+    {
+        const value_type px = p.x - center_.x;
+        const value_type py = p.y - center_.y;
+        const value_type d2 = dx * dx + dy * dy;
+        const value_type pd = px * dx + py * dy;
+        const value_type t = (std::sqrt(pd * pd + d2 * (R_ * R_ - (px * px + py * py))) - pd) / d2;
+        return {p.x + t * dx, p.y + t * dy};
+    }
+
+    // CCW along the circle from the last point of in_ to b
+    void arc(const vertex_point & b)
+    {
+        value_type ax = in_.back().x - center_.x;
+        value_type ay = in_.back().y - center_.y;
+        const value_type bx = b.x - center_.x;
+        const value_type by = b.y - center_.y;
+        // while b is not in the quadrant CCW from a
+        while ((ax * by - ay * bx < value_type(0)) || (ax * bx + ay * by < value_type(0))) {
+            ax = -std::exchange(ay, ax);
+            in_.push_back({center_.x + ax, center_.y + ay});
+        }
+    }
+
+    void make_cell(const dcel_type & dcel_, const pcell c)
+    {
+        in_.clear();
+        if (dcel_.cells_.size() == 1) { // the whole plane
+            in_.push_back({vmin.x, vmin.y});
+            in_.push_back({vmax.x, vmin.y});
+            in_.push_back({vmax.x, vmax.y});
+            in_.push_back({vmin.x, vmax.y});
+            return;
+        }
+        const site s = dcel_.cell_site(c);
+        const auto neighbour = [&] (const phalf_edge h) { return dcel_.cell_site(dcel_.cell(dcel_type::twin(h))); };
+        const auto middle = [&] (const site n) -> vertex_point { return {(s->x + n->x) / value_type(2), (s->y + n->y) / value_type(2)}; };
+        value_type R2 = R2_;
+        phalf_edge first = dcel_.cells_[c]; // from infinity, if any, then the boundary ends with the arc to it
+        dcel_.for_each_half_edge(c, [&] (const phalf_edge h)
+        {
+            const auto o = dcel_.origin(h);
+            if (o != dcel_type::inf) {
+                R2 = std::max(R2, distance2(dcel_.vertices_[o].c));
+            } else {
+                first = h;
+                if (dcel_.target(h) == dcel_type::inf) {
+                    R2 = std::max(R2, distance2(middle(neighbour(h))));
+                }
+            }
+        });
+        R_ = value_type(2) * std::sqrt(R2); // chords of pi / 2 are farther than the half of the diagonal
+        if (first == dcel_type::inf) {
+            return;
+        }
+        bool open = false; // the last point is on the circle and the boundary goes along the circle from it
+        phalf_edge h = first;
+        do {
+            const auto o = dcel_.origin(h);
+            const auto t = dcel_.target(h);
+            if ((o != dcel_type::inf) && (t != dcel_type::inf)) {
+                in_.push_back(dcel_.vertices_[o].c);
+            } else {
+                // the cell is on the left of direction (dx, dy) of the half-edge
+                const site n = neighbour(h);
+                const value_type dx = s->y - n->y;
+                const value_type dy = n->x - s->x;
+                if (o == dcel_type::inf) {
+                    const vertex_point b = far_point((t == dcel_type::inf) ? middle(n) : dcel_.vertices_[t].c, -dx, -dy);
+                    if (open) {
+                        arc(b);
+                    }
+                    in_.push_back(b);
+                    open = false;
+                }
+                if (t == dcel_type::inf) {
+                    const vertex_point e = (o == dcel_type::inf) ? middle(n) : dcel_.vertices_[o].c;
+                    if (o != dcel_type::inf) {
+                        in_.push_back(e);
+                    }
+                    in_.push_back(far_point(e, dx, dy));
+                    open = true;
+                }
+            }
+            h = dcel_.next(h);
+        } while (h != first);
+        if (open) {
+            arc(in_.front());
+        }
+    }
+
+    // by the half-plane a * x + b * y + c >= 0
+    void clip(const value_type a, const value_type b, const value_type c)
+    {
+        out_.clear();
+        const size_type size = in_.size();
+        for (size_type i = 0; i < size; ++i) {
+            const vertex_point & p = in_[i];
+            const vertex_point & q = in_[(i + 1 == size) ? 0 : (i + 1)];
+            const value_type fp = a * p.x + b * p.y + c;
+            const value_type fq = a * q.x + b * q.y + c;
+            if (!(fp < value_type(0))) {
+                out_.push_back(p);
+            }
+            if (((value_type(0) < fp) && (fq < value_type(0))) || ((fp < value_type(0)) && (value_type(0) < fq))) {
+                const value_type t = fp / (fp - fq);
+                out_.push_back({p.x + t * (q.x - p.x), p.y + t * (q.y - p.y)});
+            }
+        }
+        std::swap(in_, out_);
+    }
+
+};
@@ -0,0 +1,720 @@
+#include "voronoi.hpp"
+#include "incremental_voronoi.hpp"
+#include "parallel_sweepline.hpp"
+#include "chunked_sweepline.hpp"
+#include "batch_sweepline.hpp"
+#include "dcel.hpp"
+#include "box_clip.hpp"
+#include "lloyd.hpp"
+#include "point_location.hpp"
+#include "thread_pool.hpp"
+#include "predicates.hpp"
+
+#include <type_traits>
+#include <utility>
+#include <random>
+#include <iterator>
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include <string>
+#include <ostream>
+#include <iostream>
+#include <sstream>
+#include <exception>
+
+#include <cmath>
+#include <cassert>
+#include <cstdlib>
+#include <cstdint>
+
+// checks of the sweep and of its drivers against each other, every check prints its name and fails the run on a mismatch
+// inputs are the generators of voronoi.hpp with a fixed seed (uniform and gaussian sites, grids with cocircular sites)
+// usage: sweepline_check (ctest runs it)
+
+namespace
+{
+
+using value_type = double;
+using point = plane_point< value_type >;
+using size_type = std::size_t;
+using site = const point *;
+using voronoi_type = voronoi< point >;
+using sweepline_type = sweepline< site, point, value_type >;
+
+std::ostringstream log_;
+thread_pool pool_{4}; // not hardware_concurrency: strips and seams are there on any machine
+
+// sites of a generator of voronoi_type in (x, y) order
+template< typename generator >
+std::vector< point > generate(generator && _generator)
+{
+    voronoi_type voronoi_{log_};
+    voronoi_.seed(1);
+    std::stringstream text_;
+    text_.precision(std::numeric_limits< value_type >::max_digits10);
+    _generator(voronoi_, text_);
+    const std::string text = text_.str();
+    std::vector< point > points_;
+    if (!site_file::parse(text.data(), text.data() + text.size(), points_)) {
+        throw std::runtime_error{"bad output of a generator"};
+    }
+    std::sort(std::begin(points_), std::end(points_));
+    return points_;
+}
+
+struct input
+{
+
+    const char * name;
+    std::vector< point > points_;
+    bool exact; // sites are in general position or cocircular exactly (integral grids), so eps can be zero
+    bool grid; // columns of sites with equal x
+
+};
+
+std::vector< input > inputs()
+{
+    std::vector< input > inputs_;
+    inputs_.push_back({"square", generate([] (voronoi_type & v, std::ostream & out_) { v.square(out_, value_type(10000), 3000); }), true, false});
+    inputs_.push_back({"gauss", generate([] (voronoi_type & v, std::ostream & out_) { v.gauss(out_, value_type(10000), 3000); }), true, false});
+    inputs_.push_back({"rectangular_grid", generate([] (voronoi_type & v, std::ostream & out_) { v.rectangular_grid(out_, 30); }), true, true});
+    inputs_.push_back({"diagonal_grid", generate([] (voronoi_type & v, std::ostream & out_) { v.diagonal_grid(out_, 30); }), true, true});
+    inputs_.push_back({"hexagonal_grid", generate([] (voronoi_type & v, std::ostream & out_) { v.hexagonal_grid(out_, 40); }), false, true});
+    inputs_.push_back({"triangular_grid", generate([] (voronoi_type & v, std::ostream & out_) { v.triangular_grid(out_, 40); }), false, true});
+    return inputs_;
+}
+
+const value_type eps = [] { using std::sqrt; return sqrt(value_type(1) / value_type(1 << 24)); }(); // as voronoi_type has
+
+struct orientation_sink
+{
+
+    size_type * triangles;
+    size_type * cw; // or degenerate
+
+    void triangle(const site a, const site b, const site c) const
+    {
+        ++*triangles;
+        if (!(predicates::orientation(a->x, a->y, b->x, b->y, c->x, c->y, value_type(0)) < 0)) { // (0 < .) is CW
+            ++*cw;
+        }
+    }
+
+};
+
+// every triangle of delaunay_diagram is CCW, including the ones of sites on edges of the beachline (grids have plenty of them)
+bool triangles_are_ccw(const input & _input)
+{
+    size_type triangles = 0, cw = 0;
+    using delaunay_type = sweepline< site, point, value_type, tree_event_queue, no_statistics, delaunay_diagram< orientation_sink > >;
+    delaunay_type delaunay_{eps, orientation_sink{&triangles, &cw}};
+    const site first = _input.points_.data();
+    delaunay_(first, first + _input.points_.size());
+    if ((cw != 0) || (triangles == 0)) {
+        std::cerr << "  " << cw << " of " << triangles << " triangles are not CCW\n";
+        return false;
+    }
+    return true;
+}
+
+// Delaunay edges (l, r) of a kept diagram, l < r are indices of sites from first, sorted
+template< typename edges, typename index >
+std::vector< std::pair< size_type, size_type > > delaunay_edges(const edges & _edges, index && _index)
+{
+    std::vector< std::pair< size_type, size_type > > delaunay_edges_;
+    delaunay_edges_.reserve(_edges.size());
+    for (const auto & edge_ : _edges) {
+        const size_type l = _index(edge_.l), r = _index(edge_.r);
+        delaunay_edges_.emplace_back(std::min(l, r), std::max(l, r));
+    }
+    std::sort(std::begin(delaunay_edges_), std::end(delaunay_edges_));
+    return delaunay_edges_;
+}
+
+// Delaunay edges of the serial sweep, which drivers are compared with
+std::vector< std::pair< size_type, size_type > > swept_edges(const std::vector< point > & _points)
+{
+    sweepline_type sweepline_{eps};
+    const site first = _points.data();
+    sweepline_(first, first + _points.size());
+    return delaunay_edges(sweepline_.edges_, [&] (const site s) { return size_type(s - first); });
+}
+
+bool same_edges(const std::vector< std::pair< size_type, size_type > > & _edges, const std::vector< std::pair< size_type, size_type > > & _swept)
+{
+    if (_edges != _swept) {
+        const auto mismatch_ = std::mismatch(std::cbegin(_edges), std::cend(_edges), std::cbegin(_swept), std::cend(_swept));
+        std::cerr << "  " << _edges.size() << " edges instead of " << _swept.size();
+        if (mismatch_.second != std::cend(_swept)) {
+            std::cerr << ", no edge (" << mismatch_.second->first << ", " << mismatch_.second->second << ')';
+        }
+        std::cerr << '\n';
+        return false;
+    }
+    return true;
+}
+
+bool parallel_is_serial(const input & _input)
+{
+    parallel_sweepline< site, point, value_type > parallel_{eps, pool_};
+    parallel_.min_strip_size = 256; // strips, halos and seams, not a serial fallback
+    const site first = _input.points_.data();
+    parallel_(first, first + _input.points_.size());
+    return same_edges(delaunay_edges(parallel_.edges_, [&] (const site s) { return size_type(s - first); }), swept_edges(_input.points_));
+}
+
+// edges of chunked_sweepline refer to slots, sites are found by their coordinates in the input
+struct chunked_sink
+{
+
+    const std::vector< point > * points_;
+    std::vector< std::pair< size_type, size_type > > * edges_;
+
+    template< typename V >
+    void vertex(const V &) const
+    { ; }
+
+    template< typename E >
+    void edge(const E & edge_) const
+    {
+        const auto index = [&] (const point & p)
+        {
+            const auto s = std::lower_bound(std::cbegin(*points_), std::cend(*points_), p);
+            assert((s != std::cend(*points_)) && !(p < *s));
+            return size_type(std::distance(std::cbegin(*points_), s));
+        };
+        const size_type l = index(*edge_.l), r = index(*edge_.r);
+        edges_->emplace_back(std::min(l, r), std::max(l, r));
+    }
+
+};
+
+// chunks are small, so slots of sites, which left the beachline, are reused many times
+bool chunked_is_serial(const input & _input)
+{
+    std::vector< std::pair< size_type, size_type > > edges_;
+    chunked_sweepline< point, chunked_sink > chunked_{eps, chunked_sink{&_input.points_, &edges_}};
+    const size_type chunk_size = 100;
+    for (auto chunk = std::cbegin(_input.points_); chunk != std::cend(_input.points_);) {
+        const auto last = std::next(chunk, std::ptrdiff_t(std::min(chunk_size, size_type(std::distance(chunk, std::cend(_input.points_))))));
+        chunked_(chunk, last);
+        chunk = last;
+    }
+    chunked_.finish();
+    if (!(chunked_.capacity() < _input.points_.size())) {
+        std::cerr << "  " << chunked_.capacity() << " slots for " << _input.points_.size() << " sites\n";
+        return false;
+    }
+    std::sort(std::begin(edges_), std::end(edges_));
+    return same_edges(edges_, swept_edges(_input.points_));
+}
+
+// tiles of different sizes (down to one site) are swept as jobs of one batch, twice, so the second time sweeplines of workers are warm
+bool batch_is_serial(const input & _input)
+{
+    std::vector< std::vector< point > > tiles_;
+    for (auto tile = std::cbegin(_input.points_); tile != std::cend(_input.points_);) {
+        const size_type tile_size = std::min(size_type(1) << (tiles_.size() % 10), size_type(std::distance(tile, std::cend(_input.points_))));
+        tiles_.emplace_back(tile, std::next(tile, std::ptrdiff_t(tile_size)));
+        tile = std::next(tile, std::ptrdiff_t(tile_size));
+    }
+    using tile_site = std::vector< point >::const_iterator;
+    batch_sweepline< tile_site, point, value_type > batch_{eps, pool_};
+    for (size_type round = 0; round < 2; ++round) {
+        batch_(std::cbegin(tiles_), std::cend(tiles_));
+        if (batch_.size() != tiles_.size()) {
+            return false;
+        }
+        for (size_type j = 0; j < tiles_.size(); ++j) {
+            const auto & tile_ = tiles_[j];
+            const auto first = std::next(std::cbegin(batch_.edges_), std::ptrdiff_t(batch_.offsets_[j].edge));
+            const auto last = std::next(std::cbegin(batch_.edges_), std::ptrdiff_t(batch_.offsets_[j + 1].edge));
+            const auto edges_ = delaunay_edges(std::vector< decltype(batch_)::edge >(first, last),
+                                               [&] (const tile_site s) { return size_type(std::distance(std::cbegin(tile_), s)); });
+            if (!same_edges(edges_, swept_edges(tile_))) {
+                std::cerr << "  tile " << j << " of " << tile_.size() << " sites, round " << round << '\n';
+                return false;
+            }
+        }
+        std::reverse(std::begin(tiles_), std::end(tiles_));
+    }
+    return true;
+}
+
+// half-edges around every cell are linked end to start and belong to the cell, every edge is seen from both of its cells,
+// neighbours of the cells are the Delaunay graph of the serial sweep
+bool dcel_is_serial(const input & _input)
+{
+    const site first = _input.points_.data();
+    const size_type n = _input.points_.size();
+    using dcel_type = dcel< site, value_type >;
+    dcel_type dcel_{first, n};
+    dcel_sweepline< site, point, value_type > sweepline_{eps, dcel_.make_sink()};
+    sweepline_(first, first + n);
+    dcel_.finish();
+    std::vector< std::pair< size_type, size_type > > half_edges_;
+    size_type broken = 0;
+    for (size_type c = 0; c < n; ++c) {
+        dcel_.for_each_half_edge(c, [&] (const dcel_type::phalf_edge h)
+        {
+            if ((dcel_.cell(h) != c) || (dcel_.origin(dcel_.next(h)) != dcel_.target(h))) {
+                ++broken;
+            }
+            const size_type t = dcel_.cell(dcel_type::twin(h));
+            half_edges_.emplace_back(std::min(c, t), std::max(c, t));
+        });
+    }
+    if (broken != 0) {
+        std::cerr << "  " << broken << " of " << half_edges_.size() << " half-edges are not linked\n";
+        return false;
+    }
+    std::sort(std::begin(half_edges_), std::end(half_edges_));
+    std::vector< std::pair< size_type, size_type > > edges_;
+    for (auto h = std::cbegin(half_edges_); h != std::cend(half_edges_); h = std::next(h, 2)) {
+        if ((std::next(h) == std::cend(half_edges_)) || (*std::next(h) != *h)) {
+            std::cerr << "  edge (" << h->first << ", " << h->second << ") is seen from one cell\n";
+            return false;
+        }
+        edges_.push_back(*h);
+    }
+    return same_edges(edges_, swept_edges(_input.points_));
+}
+
+// polygons of box_clip tile the rectangle (areas sum to its area), they are convex and CCW, the one of a site in the rectangle contains it,
+// points of a polygon are not closer to a neighbouring site than to the own one; rectangles around all the sites and inside them
+bool box_clip_tiles(const input & _input)
+{
+    const site first = _input.points_.data();
+    const size_type n = _input.points_.size();
+    using dcel_type = dcel< site, value_type >;
+    using vertex_point = dcel_type::vertex_point;
+    dcel_type dcel_{first, n};
+    dcel_sweepline< site, point, value_type > sweepline_{eps, dcel_.make_sink()};
+    sweepline_(first, first + n);
+    dcel_.finish();
+    vertex_point vmin{_input.points_.front().x, _input.points_.front().y}, vmax = vmin;
+    for (const point & p : _input.points_) {
+        vmin = {std::min(vmin.x, p.x), std::min(vmin.y, p.y)};
+        vmax = {std::max(vmax.x, p.x), std::max(vmax.y, p.y)};
+    }
+    const value_type w = vmax.x - vmin.x, h = vmax.y - vmin.y;
+    const value_type tolerance = (w * w + h * h) * value_type(1E-9);
+    const vertex_point boxes_[][2] = {{{vmin.x - w / 8, vmin.y - h / 8}, {vmax.x + w / 8, vmax.y + h / 8}},
+                                      {{vmin.x + w / 4, vmin.y + h / 3}, {vmax.x - w / 3, vmax.y - h / 4}}};
+    for (const auto & box_ : boxes_) {
+        box_clip< site, value_type > box_clip_{box_[0], box_[1]};
+        box_clip_(dcel_);
+        value_type area{0};
+        for (size_type c = 0; c < n; ++c) {
+            const auto l = std::next(std::cbegin(box_clip_.points_), std::ptrdiff_t(box_clip_.offsets_[c]));
+            const auto r = std::next(std::cbegin(box_clip_.points_), std::ptrdiff_t(box_clip_.offsets_[c + 1]));
+            const point & s = first[c];
+            const bool inside = !(s.x < box_[0].x) && !(box_[1].x < s.x) && !(s.y < box_[0].y) && !(box_[1].y < s.y);
+            if (inside && (l == r)) {
+                std::cerr << "  no polygon of site " << c << '\n';
+                return false;
+            }
+            const size_type m = size_type(std::distance(l, r));
+            for (size_type i = 0; i < m; ++i) {
+                const vertex_point & a = l[std::ptrdiff_t(i)];
+                const vertex_point & b = l[std::ptrdiff_t((i + 1) % m)];
+                const vertex_point & z = l[std::ptrdiff_t((i + 2) % m)];
+                area += (a.x * b.y - b.x * a.y) / value_type(2);
+                const value_type turn = (b.x - a.x) * (z.y - b.y) - (b.y - a.y) * (z.x - b.x);
+                const value_type side = (b.x - a.x) * (s.y - a.y) - (b.y - a.y) * (s.x - a.x);
+                if ((turn < -tolerance) || (inside && (side < -tolerance))) {
+                    std::cerr << "  polygon of site " << c << " is not convex, CCW or does not contain the site\n";
+                    return false;
+                }
+                const value_type d2 = (a.x - s.x) * (a.x - s.x) + (a.y - s.y) * (a.y - s.y);
+                bool nearest = true;
+                dcel_.for_each_neighbour(c, [&] (const size_type o)
+                {
+                    const point & t = first[o];
+                    nearest = nearest && !((a.x - t.x) * (a.x - t.x) + (a.y - t.y) * (a.y - t.y) + tolerance < d2);
+                });
+                if (!nearest) {
+                    std::cerr << "  a point of the polygon of site " << c << " is closer to its neighbour\n";
+                    return false;
+                }
+            }
+        }
+        const value_type box_area = (box_[1].x - box_[0].x) * (box_[1].y - box_[0].y);
+        if (tolerance < std::abs(area - box_area)) {
+            std::cerr << "  area " << area << " of polygons instead of " << box_area << '\n';
+            return false;
+        }
+    }
+    return true;
+}
+
+// iterations of lloyd (serial and on the pool, with a re-sort now and then) are the ones of a plain sweep, clip and centroid of every cell;
+// the pool does not change the result at all; grids are skipped: relaxation scatters x of a column by a few ulps, then sites,
+// which x are within eps, are not in order of y, and the sweep does not support that
+bool lloyd_is_serial(const input & _input)
+{
+    if (_input.grid) {
+        return true;
+    }
+    using dcel_type = dcel< site, value_type >;
+    using vertex_point = dcel_type::vertex_point;
+    vertex_point vmin{_input.points_.front().x, _input.points_.front().y}, vmax = vmin;
+    for (const point & p : _input.points_) {
+        vmin = {std::min(vmin.x, p.x), std::min(vmin.y, p.y)};
+        vmax = {std::max(vmax.x, p.x), std::max(vmax.y, p.y)};
+    }
+    const value_type w = vmax.x - vmin.x, h = vmax.y - vmin.y;
+    vmin = {vmin.x - w / 8, vmin.y - h / 8};
+    vmax = {vmax.x + w / 8, vmax.y + h / 8};
+    std::vector< point > points_ = _input.points_;
+    std::shuffle(std::begin(points_), std::end(points_), std::mt19937_64{4}); // sites of assign() need not be sorted
+    lloyd< point > lloyd_{eps, vmin, vmax};
+    lloyd< point > parallel_{eps, vmin, vmax, pool_};
+    parallel_.block_size = 64;
+    parallel_.max_moves = 1;
+    lloyd_.assign(std::cbegin(points_), std::cend(points_));
+    parallel_.assign(std::cbegin(points_), std::cend(points_));
+    const size_type n = points_.size();
+    std::vector< size_type > order_(n);
+    std::vector< point > sorted_(n);
+    dcel_type dcel_{nullptr, 0};
+    dcel_sweepline< site, point, value_type > sweepline_{eps, dcel_.make_sink()};
+    box_clip< site, value_type > box_clip_{vmin, vmax};
+    for (size_type iteration = 0; iteration < 3; ++iteration) {
+        for (size_type i = 0; i < n; ++i) {
+            order_[i] = i;
+        }
+        std::sort(std::begin(order_), std::end(order_), [&] (const size_type l, const size_type r) { return points_[l] < points_[r]; });
+        for (size_type j = 0; j < n; ++j) {
+            sorted_[j] = points_[order_[j]];
+        }
+        const site first = sorted_.data();
+        dcel_.reset(first, n);
+        sweepline_(first, first + n);
+        dcel_.finish();
+        sweepline_.clear();
+        box_clip_(dcel_);
+        value_type max_shift{0};
+        for (size_type j = 0; j < n; ++j) {
+            const auto l = std::next(std::cbegin(box_clip_.points_), std::ptrdiff_t(box_clip_.offsets_[j]));
+            const auto r = std::next(std::cbegin(box_clip_.points_), std::ptrdiff_t(box_clip_.offsets_[j + 1]));
+            const size_type m = size_type(std::distance(l, r));
+            value_type A{0}, X{0}, Y{0};
+            for (size_type i = 0; i < m; ++i) {
+                const vertex_point & a = l[std::ptrdiff_t(i)];
+                const vertex_point & b = l[std::ptrdiff_t((i + 1) % m)];
+                const value_type cross = a.x * b.y - b.x * a.y;
+                A += cross;
+                X += (a.x + b.x) * cross;
+                Y += (a.y + b.y) * cross;
+            }
+            if (value_type(0) < A) {
+                point & p = points_[order_[j]];
+                const point c{X / (3 * A), Y / (3 * A)};
+                max_shift = std::max(max_shift, std::hypot(c.x - p.x, c.y - p.y));
+                p = c;
+            }
+        }
+        const value_type shift = lloyd_(1);
+        if (parallel_(1) != shift) {
+            std::cerr << "  iteration " << iteration << ": shifts differ on the pool\n";
+            return false;
+        }
+        std::vector< point > lloyd_points_(n), parallel_points_(n);
+        lloyd_.for_each_site([&] (const size_type i, const point & p) { lloyd_points_[i] = p; });
+        parallel_.for_each_site([&] (const size_type i, const point & p) { parallel_points_[i] = p; });
+        size_type far = 0, differ = 0;
+        for (size_type i = 0; i < n; ++i) {
+            const point & p = lloyd_points_[i];
+            if ((w + h) * value_type(1E-9) < std::max(std::abs(p.x - points_[i].x), std::abs(p.y - points_[i].y))) {
+                ++far;
+            }
+            if ((p.x != parallel_points_[i].x) || (p.y != parallel_points_[i].y)) {
+                ++differ;
+            }
+        }
+        if ((far != 0) || (differ != 0) || ((w + h) * value_type(1E-9) < std::abs(shift - max_shift))) {
+            std::cerr << "  iteration " << iteration << ": " << far << " sites are away from centroids, " << differ << " differ on the pool, shift "
+                      << shift << " instead of about " << max_shift << '\n';
+            return false;
+        }
+    }
+    return true;
+}
+
+// sites located over keep_diagram and compact_diagram are the nearest ones (brute force) to random queries around the sites and to the sites
+bool point_location_is_nearest(const input & _input)
+{
+    const site first = _input.points_.data();
+    const size_type n = _input.points_.size();
+    value_type xmin = first->x, xmax = xmin, ymin = first->y, ymax = ymin;
+    for (const point & p : _input.points_) {
+        xmin = std::min(xmin, p.x);
+        xmax = std::max(xmax, p.x);
+        ymin = std::min(ymin, p.y);
+        ymax = std::max(ymax, p.y);
+    }
+    const value_type w = xmax - xmin, h = ymax - ymin;
+    std::mt19937_64 rng{5};
+    std::uniform_real_distribution< value_type > x_{xmin - w / 4, xmax + w / 4}, y_{ymin - h / 4, ymax + h / 4};
+    std::vector< point > queries_(std::cbegin(_input.points_), std::cend(_input.points_));
+    for (size_type i = 0; i < 2000; ++i) {
+        const value_type x = x_(rng);
+        queries_.push_back({x, y_(rng)});
+    }
+    const auto sqr_distance = [] (const point & l, const point & r) { return (l.x - r.x) * (l.x - r.x) + (l.y - r.y) * (l.y - r.y); };
+    const auto nearest = [&] (const std::vector< size_type > & _located, const char * const diagram)
+    {
+        for (size_type q = 0; q < queries_.size(); ++q) {
+            const point & p = queries_[q];
+            value_type d2 = std::numeric_limits< value_type >::infinity();
+            for (const point & s : _input.points_) {
+                d2 = std::min(d2, sqr_distance(s, p));
+            }
+            if (!(_located[q] < n) || (d2 < sqr_distance(first[_located[q]], p))) {
+                std::cerr << "  query " << q << " over " << diagram << ": site " << _located[q] << " is not the nearest one\n";
+                return false;
+            }
+        }
+        return true;
+    };
+    point_location< site > location_;
+    std::vector< size_type > located_;
+    sweepline_type sweepline_{eps};
+    sweepline_(first, first + n);
+    location_.build(first, n, sweepline_.edges_);
+    location_.locate(std::cbegin(queries_), std::cend(queries_), std::back_inserter(located_));
+    if (!nearest(located_, "keep_diagram")) {
+        return false;
+    }
+    using compact_type = sweepline< site, point, value_type, tree_event_queue, no_statistics, compact_diagram >;
+    compact_type compact_{eps};
+    compact_(first, first + n);
+    location_.build(first, n, compact_.edges_);
+    located_.clear();
+    location_.locate(std::cbegin(queries_), std::cend(queries_), std::back_inserter(located_));
+    return nearest(located_, "compact_diagram");
+}
+
+// sites with integral coordinates: exactly representable as float and double, so sweeps of all the three types give the same diagram;
+// for int32_t eps is zero (orientation is exact), for float it is default_eps; kept and compact diagrams
+template< typename coordinate_type, typename vertex_type, typename diagram >
+std::vector< std::pair< size_type, size_type > > integral_edges(const std::vector< plane_point< std::int32_t > > & _points, const vertex_type eps)
+{
+    using typed_point = plane_point< coordinate_type >;
+    std::vector< typed_point > points_;
+    points_.reserve(_points.size());
+    for (const auto & p : _points) {
+        points_.push_back({coordinate_type(p.x), coordinate_type(p.y)});
+    }
+    using typed_site = const typed_point *;
+    sweepline< typed_site, typed_point, vertex_type, tree_event_queue, no_statistics, diagram > sweepline_{eps};
+    const typed_site first = points_.data();
+    sweepline_(first, first + points_.size());
+    if constexpr (std::is_same< diagram, compact_diagram >::value) {
+        return delaunay_edges(sweepline_.edges_, [] (const auto s) { return size_type(s); });
+    } else {
+        return delaunay_edges(sweepline_.edges_, [&] (const typed_site s) { return size_type(s - first); });
+    }
+}
+
+bool integral_grids()
+{
+    using integral_point = plane_point< std::int32_t >;
+    const std::int32_t magnitude = 10000;
+    std::vector< std::vector< integral_point > > grids_(2);
+    for (std::int32_t x = -magnitude; x <= magnitude; x += 7 * 47) { // cocircular sites
+        for (std::int32_t y = -magnitude; y <= magnitude; y += 5 * 47) {
+            grids_[0].push_back({x, y});
+        }
+    }
+    std::mt19937_64 rng{6};
+    std::uniform_int_distribution< std::int32_t > c_{-magnitude, magnitude};
+    for (size_type i = 0; i < 3000; ++i) {
+        const std::int32_t x = c_(rng);
+        grids_[1].push_back({x, c_(rng)});
+    }
+    for (auto & grid_ : grids_) {
+        std::sort(std::begin(grid_), std::end(grid_));
+        grid_.erase(std::unique(std::begin(grid_), std::end(grid_), [] (const integral_point & l, const integral_point & r) { return !(l < r) && !(r < l); }),
+                    std::end(grid_));
+        const auto edges_ = integral_edges< std::int32_t, double, keep_diagram >(grid_, 0.0);
+        const std::pair< const char *, std::vector< std::pair< size_type, size_type > > > typed_edges_[] =
+        {
+            {"compact int32_t", integral_edges< std::int32_t, double, compact_diagram >(grid_, 0.0)},
+            {"double", integral_edges< double, double, keep_diagram >(grid_, eps)},
+            {"compact double", integral_edges< double, double, compact_diagram >(grid_, eps)},
+            {"float", integral_edges< float, float, keep_diagram >(grid_, sweepline< const plane_point< float > *, plane_point< float >, float >::default_eps(float(magnitude)))},
+        };
+        for (const auto & typed_ : typed_edges_) {
+            if (!same_edges(typed_.second, edges_)) {
+                std::cerr << "  " << typed_.first << " of " << grid_.size() << " sites differs from int32_t\n";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// the graph of incremental_voronoi after every update() is the one of a sweep of its sites from scratch:
+// random moves, insertions and erasures, with sites on a line (collinear neighbours) and off it;
+// eps is zero, otherwise both contract nearly cocircular sites, but by different criteria (a site near the circle and a short edge)
+bool incremental_is_swept(const std::vector< point > & _points, const value_type spread, const size_type steps, const std::uint64_t seed)
+{
+    using incremental_type = incremental_voronoi< point >;
+    incremental_type incremental_{value_type(0)};
+    incremental_.assign(std::cbegin(_points), std::cend(_points));
+    std::mt19937_64 rng{seed};
+    value_type ymax{0};
+    for (const point & p : _points) {
+        ymax = std::max(ymax, p.y);
+    }
+    std::uniform_real_distribution< value_type > x_{-spread, spread}, y_{value_type(0), ymax};
+    const auto random_point = [&] () -> point
+    {
+        for (;;) { // on the line every other time, away from the others
+            const point p{((rng() % 2) == 0) ? value_type(0) : x_(rng), y_(rng)};
+            bool far = true;
+            for (size_type i = 0; far && (i < incremental_.capacity()); ++i) {
+                if (incremental_.alive(i)) {
+                    const point & q = incremental_.site(i);
+                    far = (value_type(1E-3) < std::max(std::abs(p.x - q.x), std::abs(p.y - q.y)));
+                }
+            }
+            if (far) {
+                return p;
+            }
+        }
+    };
+    const auto alive = [&] (size_type i)
+    {
+        while (!incremental_.alive(i % incremental_.capacity())) {
+            ++i;
+        }
+        return i % incremental_.capacity();
+    };
+    for (size_type step = 0; step < steps; ++step) {
+        switch (rng() % 4) {
+        case 0 :
+            incremental_.insert(random_point());
+            break;
+        case 1 :
+            if (size_type(8) < incremental_.size()) {
+                incremental_.erase(alive(size_type(rng())));
+                break;
+            }
+            [[fallthrough]];
+        default :
+            {
+                const size_type i = alive(size_type(rng()));
+                incremental_.move(i, random_point());
+            }
+            break;
+        }
+        incremental_.update();
+        std::vector< std::pair< size_type, size_type > > graph_;
+        std::vector< point > points_;
+        std::vector< size_type > ids_;
+        for (size_type i = 0; i < incremental_.capacity(); ++i) {
+            if (incremental_.alive(i)) {
+                for (const size_type n : incremental_.neighbours(i)) {
+                    if (i < n) {
+                        graph_.emplace_back(i, n);
+                    }
+                }
+                points_.push_back(incremental_.site(i));
+                ids_.push_back(i);
+            }
+        }
+        std::sort(std::begin(graph_), std::end(graph_));
+        std::vector< std::uint32_t > permutation_;
+        site_sort::radix_permutation(std::cbegin(points_), std::cend(points_), permutation_);
+        site_sort::apply_permutation(std::begin(points_), permutation_);
+        sweepline_type sweepline_{value_type(0)};
+        const site first = points_.data();
+        sweepline_(first, first + points_.size());
+        const auto swept_ = delaunay_edges(sweepline_.edges_, [&] (const site s) { return ids_[permutation_[size_type(s - first)]]; });
+        if (graph_ != swept_) {
+            std::cerr << "  step " << step << ": " << graph_.size() << " edges instead of " << swept_.size() << '\n';
+            return false;
+        }
+    }
+    return true;
+}
+
+bool incremental_collinear()
+{
+    std::vector< point > points_;
+    for (size_type i = 0; i < 50; ++i) {
+        points_.push_back({value_type(0), value_type(i)});
+    }
+    using incremental_type = incremental_voronoi< point >;
+    incremental_type incremental_{eps};
+    incremental_.assign(std::cbegin(points_), std::cend(points_));
+    incremental_.move(9, {value_type(1E-3), value_type(9)}); // neighbours 8 and 10 of 9 are collinear with it
+    incremental_.update();
+    const auto & ring_ = incremental_.neighbours(8);
+    if (std::find(std::cbegin(ring_), std::cend(ring_), size_type(10)) == std::cend(ring_)) {
+        std::cerr << "  no edge (8, 10)\n";
+        return false;
+    }
+    return incremental_is_swept(points_, value_type(1), 200, 2);
+}
+
+bool incremental_scattered(const input & _input)
+{
+    if (!_input.exact) {
+        return true;
+    }
+    std::vector< point > points_(std::cbegin(_input.points_), std::next(std::cbegin(_input.points_), 400));
+    return incremental_is_swept(points_, value_type(10000), 200, 3);
+}
+
+}
+
+int main()
+{
+    try {
+        const auto inputs_ = inputs();
+        size_type failures = 0;
+        const auto check = [&] (const char * const name, const auto & _check)
+        {
+            for (const input & input_ : inputs_) {
+                std::cout << name << ' ' << input_.name << " (" << input_.points_.size() << " sites)" << std::endl;
+                if (!_check(input_)) {
+                    std::cout << "FAILED" << std::endl;
+                    ++failures;
+                }
+            }
+        };
+        const auto check_once = [&] (const char * const name, const auto & _check)
+        {
+            std::cout << name << std::endl;
+            if (!_check()) {
+                std::cout << "FAILED" << std::endl;
+                ++failures;
+            }
+        };
+        check("triangles_are_ccw", triangles_are_ccw);
+        check("parallel_is_serial", parallel_is_serial);
+        check("chunked_is_serial", chunked_is_serial);
+        check("batch_is_serial", batch_is_serial);
+        check("dcel_is_serial", dcel_is_serial);
+        check("box_clip_tiles", box_clip_tiles);
+        check("lloyd_is_serial", lloyd_is_serial);
+        check("point_location_is_nearest", point_location_is_nearest);
+        check("incremental_scattered", incremental_scattered);
+        check_once("integral_grids", integral_grids);
+        check_once("incremental_collinear", incremental_collinear);
+        if (failures != 0) {
+            std::cout << failures << " checks failed\n";
+            return EXIT_FAILURE;
+        }
+        std::cout << "all checks passed\n";
+        return EXIT_SUCCESS;
+    } catch (const std::exception & e) {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "sweepline.hpp"
+
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <cassert>
+#include <cstddef>
+
+// sweep of sites, which come in (x, y) ordered chunks (e.g. from an external merge sort), when neither sites nor diagram fit in memory:
+// sites of a chunk are copied into slots of a pool, after the chunk the slots of sites, which are not on the beachline, are reused;
+// the diagram is streamed to the sink, its edges refer to slots, so the sink should copy sites of edges instead of keeping pointers
+template< typename point,
+          typename sink,
+          typename value_type = decltype(std::declval< point >().x),
+          typename event_queue = tree_event_queue >
+struct chunked_sweepline
+{
+
+    using site = const point *;
+    using sweepline_type = sweepline< site, point, value_type, event_queue, no_statistics, stream_diagram< sink > >;
+    using size_type = typename sweepline_type::size_type;
+
+    sweepline_type sweepline_;
+
+    chunked_sweepline(value_type eps, sink _sink)
+        : sweepline_{std::move(eps), std::move(_sink)}
+    { ; }
+
+    // sites of the next chunk, none of them is less than any site of the previous chunks
+    template< typename iterator >
+    void operator () (iterator first, const iterator last)
+    {
+        for (; first != last; ++first) {
+            point * const slot = get_slot();
+            *slot = *first;
+            assert((pushed_ == 0) || !(*slot < last_));
+            last_ = *slot;
+            ++pushed_;
+            used_.push_back(slot);
+            sweepline_.push(slot);
+        }
+        collect();
+    }
+
+    void finish()
+    {
+        sweepline_.finish();
+        free_.insert(std::cend(free_), std::cbegin(used_), std::cend(used_));
+        used_.clear();
+        pushed_ = 0;
+    }
+
+    // sites pushed since the last finish
+    size_type size() const { return pushed_; }
+    // sites in slots
+    size_type resident() const { return used_.size(); }
+    size_type capacity() const { return capacity_; }
+
+private :
+
+    static constexpr size_type min_block_size = 1024;
+
+    std::vector< std::unique_ptr< point[] > > blocks_;
+    size_type capacity_ = 0;
+
+    std::vector< point * > free_;
+    std::vector< point * > used_;
+    std::vector< site > front_;
+
+    size_type pushed_ = 0;
+    point last_{}; // order of chunks is checked against it
+
+    point * get_slot()
+    {
+        if (free_.empty()) {
+            const size_type size = std::max(capacity_, min_block_size);
+            blocks_.emplace_back(new point[size]);
+            point * const block = blocks_.back().get();
+            for (size_type i = size; 0 < i; --i) {
+                free_.push_back(block + (i - 1));
+            }
+            capacity_ += size;
+        }
+        point * const slot = free_.back();
+        free_.pop_back();
+        return slot;
+    }
+
+    // slots of sites out of the beachline are free
+    void collect()
+    {
+        front_.clear();
+        sweepline_.for_each_front_site([&] (const site s) { front_.push_back(s); });
+        std::sort(std::begin(front_), std::end(front_));
+        const auto live = [&] (const point * const slot) { return std::binary_search(std::cbegin(front_), std::cend(front_), slot); };
+        const auto dead = std::partition(std::begin(used_), std::end(used_), live);
+        free_.insert(std::cend(free_), dead, std::end(used_));
+        used_.erase(dead, std::end(used_));
+    }
+
+};
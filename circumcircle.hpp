@@ -0,0 +1,188 @@
+#pragma once
+
+#include <type_traits>
+
+#include <cstddef>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <x86intrin.h>
+#endif
+
+// circumscribed circles of triangles (a, b, c)
+// d = (a - c) x (b - c) is positive for CW triangles; for degenerate ones (d == 0) x, y and R are not finite
+// all the variants perform the same operations in the same order (as sweepline::make_vertex does too),
+// so the results are the same bit to bit, unless the compiler contracts them into FMA in its own way (-ffp-contract=off)
+namespace circumcircle
+{
+
+template< typename value_type >
+void scalar(const value_type & ax, const value_type & ay,
+            const value_type & bx, const value_type & by,
+            const value_type & cx, const value_type & cy,
+            value_type & x, value_type & y, value_type & R, value_type & d)
+{
+    const value_type cax = ax - cx;
+    const value_type cay = ay - cy;
+    const value_type cbx = bx - cx;
+    const value_type cby = by - cy;
+    d = cay * cbx - cax * cby;
+    const value_type dd = d + d;
+    const value_type A = cax * cax + cay * cay;
+    const value_type B = cbx * cbx + cby * cby;
+    x = (B * cay - A * cby) / dd;
+    y = (cbx * A - cax * B) / dd;
+    using std::sqrt;
+    R = sqrt(x * x + y * y);
+    x += cx;
+    y += cy;
+}
+
+template< std::size_t width >
+struct simd; // of doubles
+
+#if defined(__SSE2__)
+template<>
+struct simd< 2 >
+{
+
+    using vector = __m128d;
+    using value_type = double;
+
+    static __m128d load(const double * p) { return _mm_loadu_pd(p); }
+    static void store(double * p, const __m128d v) { _mm_storeu_pd(p, v); }
+    static __m128d add(const __m128d l, const __m128d r) { return _mm_add_pd(l, r); }
+    static __m128d sub(const __m128d l, const __m128d r) { return _mm_sub_pd(l, r); }
+    static __m128d mul(const __m128d l, const __m128d r) { return _mm_mul_pd(l, r); }
+    static __m128d div(const __m128d l, const __m128d r) { return _mm_div_pd(l, r); }
+    static __m128d sqrt(const __m128d v) { return _mm_sqrt_pd(v); }
+
+};
+#endif
+
+#if defined(__AVX__)
+template<>
+struct simd< 4 >
+{
+
+    using vector = __m256d;
+    using value_type = double;
+
+    static __m256d load(const double * p) { return _mm256_loadu_pd(p); }
+    static void store(double * p, const __m256d v) { _mm256_storeu_pd(p, v); }
+    static __m256d add(const __m256d l, const __m256d r) { return _mm256_add_pd(l, r); }
+    static __m256d sub(const __m256d l, const __m256d r) { return _mm256_sub_pd(l, r); }
+    static __m256d mul(const __m256d l, const __m256d r) { return _mm256_mul_pd(l, r); }
+    static __m256d div(const __m256d l, const __m256d r) { return _mm256_div_pd(l, r); }
+    static __m256d sqrt(const __m256d v) { return _mm256_sqrt_pd(v); }
+
+};
+#endif
+
+#if defined(__AVX512F__)
+template<>
+struct simd< 8 >
+{
+
+    using vector = __m512d;
+    using value_type = double;
+
+    static __m512d load(const double * p) { return _mm512_loadu_pd(p); }
+    static void store(double * p, const __m512d v) { _mm512_storeu_pd(p, v); }
+    static __m512d add(const __m512d l, const __m512d r) { return _mm512_add_pd(l, r); }
+    static __m512d sub(const __m512d l, const __m512d r) { return _mm512_sub_pd(l, r); }
+    static __m512d mul(const __m512d l, const __m512d r) { return _mm512_mul_pd(l, r); }
+    static __m512d div(const __m512d l, const __m512d r) { return _mm512_div_pd(l, r); }
+    static __m512d sqrt(const __m512d v) { return _mm512_mask_sqrt_pd(v, __mmask8(0xFF), v); } // unmasked one trips -Wmaybe-uninitialized in GCC 12
+
+};
+#endif
+
+template< std::size_t width, typename vector = typename simd< width >::vector >
+void kernel(const vector ax, const vector ay,
+            const vector bx, const vector by,
+            const vector cx, const vector cy,
+            vector & x, vector & y, vector & R, vector & d)
+{
+    using s = simd< width >;
+    const vector cax = s::sub(ax, cx);
+    const vector cay = s::sub(ay, cy);
+    const vector cbx = s::sub(bx, cx);
+    const vector cby = s::sub(by, cy);
+    d = s::sub(s::mul(cay, cbx), s::mul(cax, cby));
+    const vector dd = s::add(d, d);
+    const vector A = s::add(s::mul(cax, cax), s::mul(cay, cay));
+    const vector B = s::add(s::mul(cbx, cbx), s::mul(cby, cby));
+    x = s::div(s::sub(s::mul(B, cay), s::mul(A, cby)), dd);
+    y = s::div(s::sub(s::mul(cbx, A), s::mul(cax, B)), dd);
+    R = s::sqrt(s::add(s::mul(x, x), s::mul(y, y)));
+    x = s::add(x, cx);
+    y = s::add(y, cy);
+}
+
+#if defined(__AVX512F__)
+constexpr std::size_t widest = 8;
+#elif defined(__AVX__)
+constexpr std::size_t widest = 4;
+#elif defined(__SSE2__)
+constexpr std::size_t widest = 2;
+#endif
+
+// structure of arrays: i-th triangle is ((ax[i], ay[i]), (bx[i], by[i]), (cx[i], cy[i]))
+template< typename value_type >
+void batch(const std::size_t size,
+           const value_type * ax, const value_type * ay,
+           const value_type * bx, const value_type * by,
+           const value_type * cx, const value_type * cy,
+           value_type * x, value_type * y, value_type * R, value_type * d)
+{
+    std::size_t i = 0;
+#if defined(__SSE2__)
+    if constexpr (std::is_same< value_type, double >::value) {
+        using s = simd< widest >;
+        for (; i + widest <= size; i += widest) {
+            typename s::vector vx, vy, vR, vd;
+            kernel< widest >(s::load(ax + i), s::load(ay + i),
+                   s::load(bx + i), s::load(by + i),
+                   s::load(cx + i), s::load(cy + i),
+                   vx, vy, vR, vd);
+            s::store(x + i, vx);
+            s::store(y + i, vy);
+            s::store(R + i, vR);
+            s::store(d + i, vd);
+        }
+    }
+#endif
+    for (; i < size; ++i) {
+        scalar(ax[i], ay[i], bx[i], by[i], cx[i], cy[i], x[i], y[i], R[i], d[i]);
+    }
+}
+
+// two triangles at once, outputs are indexed by triangle
+template< typename value_type >
+void pair(const value_type (& ax)[2], const value_type (& ay)[2],
+          const value_type (& bx)[2], const value_type (& by)[2],
+          const value_type (& cx)[2], const value_type (& cy)[2],
+          value_type (& x)[2], value_type (& y)[2], value_type (& R)[2], value_type (& d)[2])
+{
+#if defined(__SSE2__)
+    if constexpr (std::is_same< value_type, double >::value) {
+        using s = simd< 2 >;
+        typename s::vector vx, vy, vR, vd;
+        kernel< 2 >(s::load(ax), s::load(ay),
+               s::load(bx), s::load(by),
+               s::load(cx), s::load(cy),
+               vx, vy, vR, vd);
+        s::store(x, vx);
+        s::store(y, vy);
+        s::store(R, vR);
+        s::store(d, vd);
+        return;
+    }
+#endif
+    for (std::size_t i = 0; i < 2; ++i) {
+        scalar(ax[i], ay[i], bx[i], by[i], cx[i], cy[i], x[i], y[i], R[i], d[i]);
+    }
+}
+
+}
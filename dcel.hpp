@@ -0,0 +1,241 @@
+#pragma once
+
+#include "sweepline.hpp"
+
+#include <type_traits>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include <cassert>
+#include <cstddef>
+
+// Half-edge (DCEL) form of the diagram, built during the sweep from the streamed vertices and edges (stream_diagram< dcel::sink >).
+// Every edge is a pair of half-edges h and twin(h) == (h ^ 1), half-edges of a cell go CCW around it (the cell is on the left),
+// next(h) starts where h ends. Boundary of an unbounded cell is closed through infinity: next of the half-edge, which goes to infinity,
+// is the one coming from infinity (origin is inf). cells_[c] is a half-edge of the cell of the site (first + c), so cell traversal is O(degree).
+template< typename site,
+          typename value_type = decltype(std::declval< typename std::iterator_traits< site >::value_type >().x) >
+struct dcel
+{
+
+    static_assert(std::is_base_of< std::random_access_iterator_tag, typename std::iterator_traits< site >::iterator_category >::value,
+                  "cells are indexed by sites");
+
+    using size_type = std::size_t;
+    using pvertex = size_type;
+    using phalf_edge = size_type;
+    using pcell = size_type;
+
+    static constexpr size_type inf = std::numeric_limits< size_type >::max();
+
+    struct vertex_point
+    {
+
+        value_type x, y;
+
+    };
+
+    struct vertex
+    {
+
+        vertex_point c;
+        value_type R;
+
+    };
+
+    struct half_edge
+    {
+
+        pcell cell; // on the left
+        pvertex origin;
+        phalf_edge next;
+
+    };
+
+    std::vector< vertex > vertices_;
+    std::vector< half_edge > half_edges_;
+    std::vector< phalf_edge > cells_; // inf for cells without edges
+
+    dcel(const site first, const size_type n)
+        : cells_(n, inf)
+        , first_{first}
+        , open_(n, inf)
+    { ; }
+
+    // as a new dcel(first, n), but capacity of all the buffers is kept, so repeated sweeps of similar sizes do not allocate
+    void reset(const site first, const size_type n)
+    {
+        vertices_.clear();
+        half_edges_.clear();
+        cells_.assign(n, inf);
+        first_ = first;
+        open_.assign(n, inf);
+        waiting_.clear();
+        chain_.clear();
+    }
+
+    struct sink
+    {
+
+        dcel * dcel_;
+
+        template< typename V >
+        void vertex(const V & v)
+        {
+            dcel_->add_vertex(v);
+        }
+
+        template< typename E >
+        void edge(const E & e)
+        {
+            dcel_->add_edge(e);
+        }
+
+    };
+
+    sink make_sink() { return {this}; }
+
+    // all the edges are passed: scratch memory is released (reset() does not need it)
+    void finish()
+    {
+        assert(std::find_if(std::cbegin(waiting_), std::cend(waiting_), [] (const size_type w) { return w != inf; }) == std::cend(waiting_));
+        waiting_ = std::vector< size_type >{}; // not = {}, which keeps capacity
+        chain_ = std::vector< size_type >{};
+    }
+
+    static phalf_edge twin(const phalf_edge h) { return h ^ 1; }
+
+    pvertex origin(const phalf_edge h) const { return half_edges_[h].origin; }
+    pvertex target(const phalf_edge h) const { return half_edges_[twin(h)].origin; }
+    phalf_edge next(const phalf_edge h) const { return half_edges_[h].next; }
+    pcell cell(const phalf_edge h) const { return half_edges_[h].cell; }
+
+    site cell_site(const pcell c) const { return std::next(first_, std::ptrdiff_t(c)); }
+
+    // CCW around the cell
+    template< typename F >
+    void for_each_half_edge(const pcell c, F && f) const
+    {
+        const phalf_edge first = cells_[c];
+        if (first == inf) {
+            return;
+        }
+        phalf_edge h = first;
+        do {
+            f(h);
+            h = next(h);
+        } while (h != first);
+    }
+
+    template< typename F >
+    void for_each_neighbour(const pcell c, F && f) const
+    {
+        for_each_half_edge(c, [&] (const phalf_edge h) { f(cell(twin(h))); });
+    }
+
+private :
+
+    site first_;
+
+    std::vector< phalf_edge > open_; // of a cell: half-edge to or from infinity, which waits for its counterpart
+    // ends of half-edges, which wait for their next or previous ones: (h << 1) for origin of h, ((h << 1) | 1) for target of h
+    std::vector< size_type > waiting_; // of a vertex: the last end waiting at it
+    std::vector< size_type > chain_; // of an end: the previous one waiting at the same vertex
+
+    template< typename V >
+    void add_vertex(const V & v)
+    {
+        vertices_.push_back({{value_type(v.c.x), value_type(v.c.y)}, value_type(v.R)});
+        waiting_.push_back(inf);
+    }
+
+    template< typename E >
+    void add_edge(const E & e)
+    {
+        // cell r is on the left of (b, e)
+        const phalf_edge h = half_edges_.size();
+        const pcell l = pcell(std::distance(first_, e.l));
+        const pcell r = pcell(std::distance(first_, e.r));
+        half_edges_.push_back({r, e.b, inf});
+        half_edges_.push_back({l, e.e, inf});
+        chain_.resize(half_edges_.size() << 1, inf);
+        for (const phalf_edge g : {h, twin(h)}) {
+            const pcell c = cell(g);
+            if (cells_[c] == inf) {
+                cells_[c] = g;
+            }
+            const pvertex o = origin(g);
+            const pvertex t = target(g);
+            if (o == inf) {
+                if (t == inf) {
+                    close_line(g);
+                } else {
+                    close(open_[c], g, false);
+                }
+            } else if (t == inf) {
+                close(open_[c], g, true);
+            }
+            if (o != inf) {
+                match(o, g << 1);
+            }
+            if (t != inf) {
+                match(t, (g << 1) | 1);
+            }
+        }
+    }
+
+    // cell has at most one half-edge to infinity and one from it, except strips between parallel lines (all sites are collinear)
+    void close(phalf_edge & open, const phalf_edge g, const bool to_infinity)
+    {
+        if (open == inf) {
+            open = g;
+        } else if (to_infinity) {
+            half_edges_[g].next = std::exchange(open, inf);
+        } else {
+            half_edges_[std::exchange(open, inf)].next = g;
+        }
+    }
+
+    void close_line(const phalf_edge g)
+    {
+        phalf_edge & open = open_[cell(g)];
+        if (open == inf) {
+            half_edges_[g].next = g;
+            open = g;
+        } else {
+            half_edges_[g].next = open;
+            half_edges_[std::exchange(open, inf)].next = g;
+        }
+    }
+
+    // the end is linked with the end of the other half-edge of the same cell, which is waiting at the vertex, else it waits
+    void match(const pvertex v, const size_type end)
+    {
+        const phalf_edge g = (end >> 1);
+        const pcell c = cell(g);
+        for (size_type * w = &waiting_[v]; *w != inf; w = &chain_[*w]) {
+            const size_type k = *w;
+            if (((k & 1) != (end & 1)) && (cell(k >> 1) == c)) {
+                if ((end & 1) == 0) {
+                    half_edges_[k >> 1].next = g;
+                } else {
+                    half_edges_[g].next = (k >> 1);
+                }
+                *w = chain_[k];
+                return;
+            }
+        }
+        chain_[end] = std::exchange(waiting_[v], end);
+    }
+
+};
+
+// sweepline, which passes the diagram to dcel< site >::sink
+template< typename site,
+          typename point = typename std::iterator_traits< site >::value_type,
+          typename value_type = decltype(std::declval< point >().x),
+          typename event_queue = tree_event_queue >
+using dcel_sweepline = sweepline< site, point, value_type, event_queue, no_statistics, stream_diagram< typename dcel< site, value_type >::sink > >;
@@ -0,0 +1,402 @@
+#pragma once
+
+#include "site_file.hpp"
+
+#include <type_traits>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <vector>
+#include <limits>
+#include <system_error>
+#include <stdexcept>
+
+#include <cassert>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// output of kept diagrams (keep_diagram or compact_diagram)
+// binary file: header, then vertices (x, y, R) and edges (l, r, b, e) with 32-bit indices of sites and vertices (inf is ~0) in native byte order,
+// either as packed records (rows) or as separate columns x, y, R, l, r, b, e (columns), every array starts at a multiple of 64 bytes;
+// it is written by writev(2): arrays, which are already laid out as in the file (e.g. columns of compact_diagram), are passed as is,
+// the rest is converted through one buffer; it is read back in place from a site_file::mapped_file
+namespace diagram_file
+{
+
+using site_file::dtype;
+using site_file::dtype_of;
+using site_file::mapped_file;
+
+enum class layout : std::uint32_t
+{
+    rows = 1,
+    columns = 2,
+};
+
+constexpr std::size_t alignment = 64;
+
+constexpr std::uint32_t inf = std::numeric_limits< std::uint32_t >::max();
+
+struct header
+{
+
+    static constexpr char signature[8] = {'s', 'w', 'e', 'e', 'p', 'd', 'i', 'a'};
+    static constexpr std::uint32_t current_version = 1;
+
+    char magic[8];
+    std::uint32_t version; // also detects foreign byte order
+    layout format;
+    dtype coordinate; // of x and y
+    dtype radius; // of R
+    std::uint64_t sites;
+    std::uint64_t vertices;
+    std::uint64_t edges;
+    char reserved[16];
+
+};
+
+static_assert(sizeof(header) == alignment, "arrays are aligned by the header");
+
+struct edge
+{
+
+    std::uint32_t l, r, b, e;
+
+};
+
+static_assert(sizeof(edge) == 4 * sizeof(std::uint32_t), "edges are packed");
+
+constexpr std::size_t padding(const std::uint64_t offset)
+{
+    return std::size_t((alignment - offset % alignment) % alignment);
+}
+
+// gathers pieces of the file and writes them by writev(2): put() keeps a reference until flush(), copy() goes through the buffer
+class writer
+{
+
+    static constexpr std::size_t buffer_size = std::size_t(1) << 16;
+    static constexpr std::size_t max_pieces = IOV_MAX;
+
+    int fd_ = -1;
+    std::uint64_t offset_ = 0;
+    std::vector< ::iovec > pieces_;
+    std::vector< char > buffer_ = std::vector< char >(buffer_size);
+    std::size_t used_ = 0;
+
+public :
+
+    explicit
+    writer(const char * const path)
+        : fd_{::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)}
+    {
+        if (fd_ < 0) {
+            throw std::system_error{errno, std::generic_category(), path};
+        }
+        pieces_.reserve(max_pieces);
+    }
+
+    writer(const writer &) = delete;
+    writer(writer &&) = delete;
+    void operator = (const writer &) = delete;
+    void operator = (writer &&) = delete;
+
+    ~writer()
+    {
+        ::close(fd_);
+    }
+
+    std::uint64_t offset() const { return offset_; }
+
+    void put(const void * const data, const std::size_t size)
+    {
+        if (size == 0) {
+            return;
+        }
+        offset_ += size;
+        if (!pieces_.empty()) {
+            ::iovec & last = pieces_.back();
+            if (static_cast< const char * >(last.iov_base) + last.iov_len == data) {
+                last.iov_len += size;
+                return;
+            }
+        }
+        pieces_.push_back({const_cast< void * >(data), size});
+        if (pieces_.size() == max_pieces) {
+            flush();
+        }
+    }
+
+    void copy(const void * const data, const std::size_t size)
+    {
+        assert(size <= buffer_size);
+        if (buffer_size - used_ < size) {
+            flush();
+        }
+        char * const destination = buffer_.data() + used_;
+        std::memcpy(destination, data, size);
+        used_ += size;
+        put(destination, size);
+    }
+
+    void align()
+    {
+        static constexpr char zeros[alignment] = {};
+        copy(zeros, padding(offset_));
+    }
+
+    void flush()
+    {
+        ::iovec * first = pieces_.data();
+        ::iovec * const last = first + pieces_.size();
+        while (first != last) {
+            const ::ssize_t written = ::writev(fd_, first, int(last - first));
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::system_error{errno, std::generic_category(), "diagram file"};
+            }
+            auto rest = std::size_t(written);
+            for (; (first != last) && !(rest < first->iov_len); ++first) {
+                rest -= first->iov_len;
+            }
+            if (first != last) { // partially written piece
+                first->iov_base = static_cast< char * >(first->iov_base) + rest;
+                first->iov_len -= rest;
+            }
+        }
+        pieces_.clear();
+        used_ = 0;
+    }
+
+};
+
+template< typename value_type, typename F >
+void put_column(writer & writer_, const value_type * const data, const std::size_t size, F && f)
+{
+    writer_.align();
+    if (data) {
+        writer_.put(data, size * sizeof(value_type));
+    } else {
+        for (std::size_t i = 0; i < size; ++i) {
+            const value_type value = f(i);
+            writer_.copy(&value, sizeof value);
+        }
+    }
+}
+
+// sites of edges are counted from first, which should be the first site of the sweep (it is ignored for compact_diagram)
+template< typename sweepline, typename site >
+void write(const char * const path, const sweepline & sweepline_, const site first, const std::size_t sites,
+           const layout format = layout::rows)
+{
+    using vertex = typename sweepline::vertex;
+    using coordinate = std::remove_cv_t< decltype(vertex::c.x) >;
+    using radius = std::remove_cv_t< decltype(vertex::R) >;
+    const auto & vertices_ = sweepline_.vertices_;
+    const auto & edges_ = sweepline_.edges_;
+    const std::size_t vertices = vertices_.size();
+    const std::size_t edges = edges_.size();
+    if ((std::numeric_limits< std::uint32_t >::max() / 3 <= sites) || (inf <= vertices)) {
+        throw std::length_error{"diagram file: 32-bit indices overflow"};
+    }
+    const auto vertex_index = [&] (const auto v) { return (v == sweepline_.inf) ? inf : std::uint32_t(v); };
+    const auto site_index = [&] (const auto s)
+    {
+        if constexpr (sweepline::compact) {
+            return std::uint32_t(s);
+        } else {
+            return std::uint32_t(std::distance(typename sweepline::psite{first}, s));
+        }
+    };
+    const auto get_edge = [&] (const std::size_t i) -> edge
+    {
+        const auto & edge_ = edges_[i];
+        return {site_index(edge_.l), site_index(edge_.r), vertex_index(edge_.b), vertex_index(edge_.e)};
+    };
+    header header_ = {};
+    std::copy(std::cbegin(header::signature), std::cend(header::signature), header_.magic);
+    header_.version = header::current_version;
+    header_.format = format;
+    header_.coordinate = dtype_of< coordinate >();
+    header_.radius = dtype_of< radius >();
+    header_.sites = sites;
+    header_.vertices = vertices;
+    header_.edges = edges;
+    writer writer_{path};
+    writer_.put(&header_, sizeof header_);
+    if (format == layout::rows) {
+        constexpr std::size_t record_size = 2 * sizeof(coordinate) + sizeof(radius);
+        if constexpr (sweepline::compact) {
+            for (std::size_t v = 0; v < vertices; ++v) {
+                char record[record_size];
+                std::memcpy(record, &vertices_.x[v], sizeof(coordinate));
+                std::memcpy(record + sizeof(coordinate), &vertices_.y[v], sizeof(coordinate));
+                std::memcpy(record + 2 * sizeof(coordinate), &vertices_.R[v], sizeof(radius));
+                writer_.copy(record, record_size);
+            }
+        } else if ((sizeof(vertex) == record_size) && !vertices_.empty()
+                   && (reinterpret_cast< const char * >(&vertices_.front().c.y) == reinterpret_cast< const char * >(&vertices_.front().c.x) + sizeof(coordinate))
+                   && (reinterpret_cast< const char * >(&vertices_.front().R) == reinterpret_cast< const char * >(&vertices_.front().c.x) + 2 * sizeof(coordinate))) {
+            writer_.put(vertices_.data(), vertices * record_size); // x, y, R without padding
+        } else {
+            for (const vertex & vertex_ : vertices_) {
+                char record[record_size];
+                std::memcpy(record, &vertex_.c.x, sizeof(coordinate));
+                std::memcpy(record + sizeof(coordinate), &vertex_.c.y, sizeof(coordinate));
+                std::memcpy(record + 2 * sizeof(coordinate), &vertex_.R, sizeof(radius));
+                writer_.copy(record, record_size);
+            }
+        }
+        writer_.align();
+        if constexpr (sweepline::compact && (sizeof(typename sweepline::edge) == sizeof(edge))) {
+            writer_.put(edges_.data(), edges * sizeof(edge)); // l, r, b, e handles
+        } else {
+            for (std::size_t i = 0; i < edges; ++i) {
+                const edge edge_ = get_edge(i);
+                writer_.copy(&edge_, sizeof edge_);
+            }
+        }
+    } else {
+        assert(format == layout::columns);
+        if constexpr (sweepline::compact) {
+            put_column(writer_, vertices_.x.data(), vertices, [] (std::size_t) { return coordinate{}; });
+            put_column(writer_, vertices_.y.data(), vertices, [] (std::size_t) { return coordinate{}; });
+            put_column(writer_, vertices_.R.data(), vertices, [] (std::size_t) { return radius{}; });
+        } else {
+            put_column(writer_, static_cast< const coordinate * >(nullptr), vertices, [&] (const std::size_t v) { return vertices_[v].c.x; });
+            put_column(writer_, static_cast< const coordinate * >(nullptr), vertices, [&] (const std::size_t v) { return vertices_[v].c.y; });
+            put_column(writer_, static_cast< const radius * >(nullptr), vertices, [&] (const std::size_t v) { return vertices_[v].R; });
+        }
+        const std::uint32_t * const none = nullptr;
+        put_column(writer_, none, edges, [&] (const std::size_t i) { return site_index(edges_[i].l); });
+        put_column(writer_, none, edges, [&] (const std::size_t i) { return site_index(edges_[i].r); });
+        put_column(writer_, none, edges, [&] (const std::size_t i) { return vertex_index(edges_[i].b); });
+        put_column(writer_, none, edges, [&] (const std::size_t i) { return vertex_index(edges_[i].e); });
+    }
+    writer_.flush();
+}
+
+// header of a binary file, throws if the file is not of the format
+inline
+const header & get_header(const mapped_file & _file)
+{
+    if (_file.size() < sizeof(header)) {
+        throw std::runtime_error{"diagram file: no header"};
+    }
+    const auto & header_ = *reinterpret_cast< const header * >(_file.data());
+    if (std::memcmp(header_.magic, header::signature, sizeof header::signature) != 0) {
+        throw std::runtime_error{"diagram file: bad signature"};
+    }
+    if (header_.version != header::current_version) {
+        throw std::runtime_error{"diagram file: unsupported version or byte order"};
+    }
+    return header_;
+}
+
+// the diagram of the binary file in place: i-th value of a field is at base + i * stride (unaligned in rows of mixed types)
+template< typename coordinate, typename radius = coordinate >
+struct diagram
+{
+
+    struct vertex
+    {
+
+        coordinate x, y;
+        radius R;
+
+    };
+
+    struct field
+    {
+
+        const char * base;
+        std::size_t stride;
+
+        template< typename value_type >
+        value_type get(const std::size_t i) const
+        {
+            value_type value;
+            std::memcpy(&value, base + i * stride, sizeof value);
+            return value;
+        }
+
+    };
+
+    std::uint64_t sites, vertices, edges;
+    field x, y, R, l, r, b, e;
+
+    vertex get_vertex(const std::size_t v) const
+    {
+        assert(v < vertices);
+        return {x.get< coordinate >(v), y.get< coordinate >(v), R.get< radius >(v)};
+    }
+
+    edge get_edge(const std::size_t i) const
+    {
+        assert(i < edges);
+        return {l.get< std::uint32_t >(i), r.get< std::uint32_t >(i), b.get< std::uint32_t >(i), e.get< std::uint32_t >(i)};
+    }
+
+};
+
+template< typename coordinate, typename radius = coordinate >
+diagram< coordinate, radius > get_diagram(const mapped_file & _file)
+{
+    const header & header_ = diagram_file::get_header(_file);
+    if ((header_.coordinate != dtype_of< coordinate >()) || (header_.radius != dtype_of< radius >())) {
+        throw std::runtime_error{"diagram file: unexpected coordinate type"};
+    }
+    diagram< coordinate, radius > diagram_;
+    diagram_.sites = header_.sites;
+    diagram_.vertices = header_.vertices;
+    diagram_.edges = header_.edges;
+    const std::uint64_t vertices = header_.vertices, edges = header_.edges;
+    if ((std::numeric_limits< std::uint32_t >::max() < vertices) || (std::numeric_limits< std::uint32_t >::max() < edges)) {
+        throw std::runtime_error{"diagram file: bad header"};
+    }
+    std::uint64_t offset = sizeof(header);
+    const auto take = [&] (const std::uint64_t size) -> const char *
+    {
+        offset += padding(offset);
+        const char * const base = _file.data() + offset;
+        offset += size;
+        return base;
+    };
+    constexpr std::size_t record_size = 2 * sizeof(coordinate) + sizeof(radius);
+    if (header_.format == layout::rows) {
+        const char * const v = take(vertices * record_size);
+        diagram_.x = {v, record_size};
+        diagram_.y = {v + sizeof(coordinate), record_size};
+        diagram_.R = {v + 2 * sizeof(coordinate), record_size};
+        const char * const e = take(edges * sizeof(edge));
+        diagram_.l = {e, sizeof(edge)};
+        diagram_.r = {e + sizeof(std::uint32_t), sizeof(edge)};
+        diagram_.b = {e + 2 * sizeof(std::uint32_t), sizeof(edge)};
+        diagram_.e = {e + 3 * sizeof(std::uint32_t), sizeof(edge)};
+    } else if (header_.format == layout::columns) {
+        diagram_.x = {take(vertices * sizeof(coordinate)), sizeof(coordinate)};
+        diagram_.y = {take(vertices * sizeof(coordinate)), sizeof(coordinate)};
+        diagram_.R = {take(vertices * sizeof(radius)), sizeof(radius)};
+        diagram_.l = {take(edges * sizeof(std::uint32_t)), sizeof(std::uint32_t)};
+        diagram_.r = {take(edges * sizeof(std::uint32_t)), sizeof(std::uint32_t)};
+        diagram_.b = {take(edges * sizeof(std::uint32_t)), sizeof(std::uint32_t)};
+        diagram_.e = {take(edges * sizeof(std::uint32_t)), sizeof(std::uint32_t)};
+    } else {
+        throw std::runtime_error{"diagram file: unknown layout"};
+    }
+    if (_file.size() < offset) {
+        throw std::runtime_error{"diagram file: truncated"};
+    }
+    return diagram_;
+}
+
+}
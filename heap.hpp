@@ -0,0 +1,411 @@
+#pragma once
+
+#include <type_traits>
+#include <utility>
+#include <iterator>
+#include <memory>
+#include <vector>
+#include <algorithm>
+
+#include <cassert>
+#include <cstddef>
+
+namespace heap
+{
+
+template< typename K, typename V >
+struct pair { K k; V v; };
+
+template< typename type >
+struct node
+{
+
+    union { type value; };
+
+    node * next; // next node in the bucket or in the pool
+    std::size_t i; // position in the heap
+    std::size_t h; // hash of the cell
+
+    node() noexcept { ; }
+
+    node(const node &) = delete;
+    node(node &&) = delete;
+    void operator = (const node &) = delete;
+    void operator = (node &&) = delete;
+
+    ~node() { ; }
+
+    type * pointer() noexcept { return &value; }
+
+};
+
+template< typename type >
+struct queue_iterator
+{
+
+    using value_type = type;
+    using reference = type &;
+    using pointer = type *;
+
+    using node_type = node< std::remove_const_t< value_type > >;
+    using node_pointer = node_type *;
+
+    node_pointer p = nullptr;
+
+    pointer operator -> () const noexcept { return p->pointer(); }
+    reference operator * () const noexcept { return *operator -> (); }
+
+    bool operator == (const queue_iterator it) const noexcept { return p == it.p; }
+    bool operator != (const queue_iterator it) const noexcept { return !operator == (it); }
+
+    operator queue_iterator< const type > () const { return {p}; }
+
+};
+
+// indexed d-ary heap: handles to elements are stable, any element can be erased in O(d * log(n) / log(d))
+// elements, which are equivalent to a given key, are looked up through the hash table of cells:
+// locator.cell(k) is a hash of the cell containing k, locator.cells(k, f) calls f for hashes of all the cells,
+// which can contain elements equivalent to k
+template< typename type,
+          typename compare,
+          typename locator,
+          std::size_t arity = 4,
+          typename allocator = std::allocator< type > >
+struct queue
+{
+
+    static_assert(1 < arity, "arity should be at least 2");
+
+    using size_type = std::size_t;
+    using value_type = type;
+    using compare_type = compare;
+    using locator_type = locator;
+    using allocator_type = allocator;
+
+    using key_type = std::remove_const_t< decltype(std::declval< value_type >().k) >;
+
+private :
+
+    compare_type c;
+    locator_type l;
+
+    using node_type = node< value_type >;
+    using node_pointer = node_type *;
+
+    using allocator_traits = typename std::allocator_traits< allocator >::template rebind_traits< node_type >;
+    using node_allocator_type = typename allocator_traits::allocator_type;
+
+    node_allocator_type a;
+
+    node_pointer pool = nullptr;
+
+    // first node of each block is a header: next points to the next block, i is a size of the block
+    node_pointer blocks = nullptr;
+    size_type capacity = 0;
+
+    static constexpr size_type min_block_size = 64;
+
+    void put_node(const node_pointer n) noexcept
+    {
+        n->next = std::exchange(pool, n);
+    }
+
+    void add_block(const size_type n)
+    {
+        const node_pointer b = ::new (allocator_traits::allocate(a, n + 1)) node_type;
+        b->next = std::exchange(blocks, b);
+        b->i = n + 1;
+        for (size_type i = n; 0 < i; --i) {
+            put_node(::new (b + i) node_type);
+        }
+        capacity += n;
+    }
+
+    void drop_blocks() noexcept
+    {
+        while (blocks) {
+            const node_pointer b = blocks;
+            blocks = b->next;
+            const size_type n = b->i;
+            for (size_type i = 0; i < n; ++i) {
+                b[i].~node_type();
+            }
+            allocator_traits::deallocate(a, b, n);
+        }
+        pool = nullptr;
+        capacity = 0;
+    }
+
+    node_pointer
+    get_node()
+    {
+        if (!pool) {
+            add_block(std::max(capacity, min_block_size));
+        }
+        return std::exchange(pool, pool->next);
+    }
+
+    struct entry
+    {
+
+        key_type k; // copy of the key: sifting does not touch nodes
+        node_pointer n;
+
+    };
+
+    template< typename T >
+    using rebind_allocator = typename std::allocator_traits< allocator >::template rebind_alloc< T >;
+
+    std::vector< entry, rebind_allocator< entry > > entries;
+    std::vector< node_pointer, rebind_allocator< node_pointer > > buckets; // size is a power of 2
+
+    bool less(const size_type i, const size_type j) const
+    {
+        return c(entries[i].k, entries[j].k);
+    }
+
+    void place(const size_type i, entry && e) noexcept
+    {
+        e.n->i = i;
+        entries[i] = std::move(e);
+    }
+
+    void sift_up(size_type i) noexcept
+    {
+        entry e = std::move(entries[i]);
+        while (0 < i) {
+            const size_type p = (i - 1) / arity;
+            if (!c(e.k, entries[p].k)) {
+                break;
+            }
+            place(i, std::move(entries[p]));
+            i = p;
+        }
+        place(i, std::move(e));
+    }
+
+    void sift_down(size_type i) noexcept
+    {
+        const size_type s = entries.size();
+        entry e = std::move(entries[i]);
+        for (;;) {
+            size_type m = arity * i + 1;
+            if (!(m < s)) {
+                break;
+            }
+            const size_type r = std::min(m + arity, s);
+            for (size_type j = m + 1; j < r; ++j) {
+                if (less(j, m)) {
+                    m = j;
+                }
+            }
+            if (!c(entries[m].k, e.k)) {
+                break;
+            }
+            place(i, std::move(entries[m]));
+            i = m;
+        }
+        place(i, std::move(e));
+    }
+
+    node_pointer & bucket(const size_type h) noexcept
+    {
+        return buckets[h & (buckets.size() - 1)];
+    }
+
+    void link(const node_pointer n) noexcept
+    {
+        n->next = std::exchange(bucket(n->h), n);
+    }
+
+    void unlink(const node_pointer n) noexcept
+    {
+        node_pointer * p = &bucket(n->h);
+        while (*p != n) {
+            assert(*p);
+            p = &(*p)->next;
+        }
+        *p = n->next;
+    }
+
+    void rehash(size_type n)
+    {
+        size_type b = 16;
+        while (b < n + n) {
+            b += b;
+        }
+        if (b <= buckets.size()) {
+            return;
+        }
+        buckets.assign(b, nullptr);
+        for (const entry & e : entries) {
+            link(e.n);
+        }
+    }
+
+public :
+
+    using iterator = queue_iterator< value_type >;
+    using const_iterator = queue_iterator< const value_type >;
+
+    explicit
+    queue(const compare_type & comp, const allocator_type & alloc = allocator_type{})
+        : c{comp}
+        , l{comp}
+        , a{alloc}
+        , entries(alloc)
+        , buckets(alloc)
+    { ; }
+
+    queue(const queue &) = delete;
+    queue(queue &&) = delete;
+    void operator = (const queue &) = delete;
+    void operator = (queue &&) = delete;
+
+    size_type size() const noexcept { return entries.size(); }
+
+    bool empty() const noexcept { return entries.empty(); }
+
+    void reserve(const size_type n)
+    {
+        if (capacity < n) {
+            add_block(n - capacity);
+        }
+        entries.reserve(n);
+        rehash(n);
+    }
+
+    // memory taken by reserve(n) of an empty queue
+    static constexpr size_type reserved_bytes(const size_type n) noexcept
+    {
+        size_type b = 16;
+        while (b < n + n) {
+            b += b;
+        }
+        return (n + 1) * sizeof(node_type) + n * sizeof(entry) + b * sizeof(node_pointer);
+    }
+
+    void clear() noexcept
+    {
+        for (const entry & e : entries) {
+            allocator_traits::destroy(a, e.n->pointer());
+        }
+        entries.clear();
+        buckets.clear();
+        drop_blocks();
+    }
+
+    ~queue() noexcept
+    {
+        clear();
+    }
+
+    // there is no traversal: begin() is the least element
+    iterator begin() { return {empty() ? nullptr : entries.front().n}; }
+    iterator end() { return {nullptr}; }
+
+    const_iterator begin() const { return {empty() ? nullptr : entries.front().n}; }
+    const_iterator end() const { return {nullptr}; }
+
+    template< typename K >
+    iterator
+    find(const K & k)
+    {
+        node_pointer n = nullptr;
+        if (!empty()) {
+            l.cells(k, [&] (const size_type h)
+            {
+                if (!n) {
+                    for (node_pointer p = bucket(h); p; p = p->next) {
+                        const key_type & key = p->pointer()->k;
+                        if (!c(k, key) && !c(key, k)) {
+                            n = p;
+                            break;
+                        }
+                    }
+                }
+            });
+        }
+        return {n};
+    }
+
+    // unlike in rb_tree::tree there should not be any element equivalent to the inserted one
+    template< typename V = value_type >
+    pair< iterator, bool >
+    insert(V && v)
+    {
+        rehash(size() + 1);
+        if (entries.size() == entries.capacity()) { // geometric growth before the node is taken, so push_back below does not throw
+            entries.reserve(2 * entries.size() + 1);
+        }
+        const node_pointer n = get_node();
+        try {
+            allocator_traits::construct(a, n->pointer(), std::forward< V >(v));
+        } catch (...) {
+            put_node(n);
+            throw;
+        }
+        const key_type & k = n->pointer()->k;
+        n->h = l.cell(k);
+        link(n);
+        entries.push_back({k, n});
+        sift_up(entries.size() - 1);
+        return {{n}, true};
+    }
+
+    void erase(const const_iterator it) noexcept
+    {
+        const node_pointer n = it.p;
+        assert(n);
+        const size_type i = n->i;
+        assert(entries[i].n == n);
+        unlink(n);
+        if (i + 1 == entries.size()) {
+            entries.pop_back();
+        } else {
+            place(i, std::move(entries.back()));
+            entries.pop_back();
+            if ((0 < i) && less(i, (i - 1) / arity)) {
+                sift_up(i);
+            } else {
+                sift_down(i);
+            }
+        }
+        allocator_traits::destroy(a, n->pointer());
+        put_node(n);
+    }
+
+    // erases every element, for which f(element) is true (f is called once for each of them), then the heap is rebuilt in O(n)
+    template< typename F >
+    void erase_if(F && f)
+    {
+        size_type j = 0;
+        for (size_type i = 0; i < entries.size(); ++i) {
+            const node_pointer n = entries[i].n;
+            if (f(std::as_const(*n->pointer()))) {
+                unlink(n);
+                allocator_traits::destroy(a, n->pointer());
+                put_node(n);
+            } else {
+                place(j++, std::move(entries[i]));
+            }
+        }
+        entries.erase(std::next(std::begin(entries), std::ptrdiff_t(j)), std::end(entries));
+        if (1 < j) {
+            for (size_type i = (j - 2) / arity + 1; 0 < i; --i) {
+                sift_down(i - 1);
+            }
+        }
+    }
+
+};
+
+template< typename key_type,
+          typename mapped_type,
+          typename compare,
+          typename locator,
+          std::size_t arity = 4,
+          typename allocator_type = std::allocator< pair< key_type const, mapped_type > > >
+using map = queue< typename allocator_type::value_type, compare, locator, arity, allocator_type >;
+
+}
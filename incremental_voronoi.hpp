@@ -0,0 +1,624 @@
+#pragma once
+
+#include "sweepline.hpp"
+
+#include <type_traits>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include <cassert>
+#include <cstddef>
+#include <cmath>
+
+// Voronoi diagram under insertion, deletion and movement of sites
+// The diagram is kept as a planar map of the dual (Delaunay) graph: neighbours(i) are sites, which cells share an edge with the cell of i,
+// in CCW order around i; a Voronoi vertex of i is the circumcenter of i and two consecutive neighbours, if the angle between them is less than pi.
+// Insertion locates the nearest site by a greedy walk over the graph, sweeps a few rings of its neighbours together with the new site
+// and verifies, that circles of the new cell are empty (by greedy walks too), otherwise the rings are doubled;
+// then edges between new neighbours, which the new cell covers completely, are removed.
+// Deletion sweeps vertices of the faces around the site and takes the edges of the hole.
+// Once the number of changes since update() exceeds max_fraction of sites, changes are only recorded and update() sweeps all the sites.
+template< typename point,
+          typename value_type = decltype(std::declval< point >().x) >
+struct incremental_voronoi
+{
+
+    using size_type = std::size_t;
+    using psite = size_type; // stable index of a site, it is reused after erase()
+    using ring = std::vector< psite >;
+
+    using promoted_type = decltype(std::declval< value_type >() * 0.0);
+
+    explicit
+    incremental_voronoi(value_type eps)
+        : eps_{eps}
+        , sweepline_{std::move(eps)}
+    {
+        assert(!(eps_ < value_type(0)));
+    }
+
+    double max_fraction = 0.1;
+    size_type min_size = 16; // of local updates, smaller sets are swept entirely
+
+    size_type rebuilds = 0; // full sweeps
+
+    template< typename iterator >
+    void assign(iterator first, const iterator last)
+    {
+        points_.assign(first, last);
+        alive_.assign(points_.size(), char(true));
+        free_.clear();
+        rebuild();
+    }
+
+    // distances from the other sites should exceed eps
+    psite insert(const point & p)
+    {
+        psite i;
+        if (free_.empty()) {
+            i = points_.size();
+            points_.push_back(p);
+            alive_.push_back(char(false));
+            rings_.emplace_back();
+        } else {
+            i = free_.back();
+            free_.pop_back();
+        }
+        place(i, p);
+        return i;
+    }
+
+    void erase(const psite i)
+    {
+        remove(i);
+        free_.push_back(i);
+    }
+
+    void move(const psite i, const point & p)
+    {
+        remove(i);
+        place(i, p);
+    }
+
+    // diagram is valid after update()
+    void update()
+    {
+        if (dirty_) {
+            rebuild();
+        }
+        changes_ = 0;
+    }
+
+    bool valid() const { return !dirty_; }
+
+    size_type size() const { return points_.size() - free_.size(); }
+    size_type capacity() const { return points_.size(); }
+
+    bool alive(const psite i) const { return (i < alive_.size()) && alive_[i]; }
+    const point & site(const psite i) const { return points_[i]; }
+
+    const ring & neighbours(const psite i) const
+    {
+        assert(valid());
+        assert(alive(i));
+        return rings_[i];
+    }
+
+private :
+
+    using sweepline_type = sweepline< const point *, point, value_type >;
+
+    const value_type eps_;
+    sweepline_type sweepline_;
+
+    std::vector< point > points_;
+    std::vector< char > alive_;
+    std::vector< psite > free_;
+    std::vector< ring > rings_;
+
+    psite hint_ = 0; // start of walks
+    size_type changes_ = 0;
+    bool dirty_ = false;
+
+    // scratch
+    std::vector< psite > local_;
+    std::vector< point > sorted_;
+    std::vector< psite > ids_; // of sorted_
+    std::vector< size_type > marks_;
+    size_type stamp_ = 0;
+    ring ring_;
+    std::vector< std::pair< psite, psite > > removed_;
+
+    struct sector // of a face at the site l, from CCW to r
+    {
+
+        psite s, l, r;
+
+    };
+
+    std::vector< sector > sectors_;
+
+    promoted_type cross(const psite o, const psite a, const point & b) const
+    {
+        const point & oo = points_[o];
+        const point & aa = points_[a];
+        return (promoted_type(aa.x) - promoted_type(oo.x)) * (promoted_type(b.y) - promoted_type(oo.y))
+             - (promoted_type(aa.y) - promoted_type(oo.y)) * (promoted_type(b.x) - promoted_type(oo.x));
+    }
+
+    template< typename P >
+    static
+    promoted_type sqr_distance(const point & a, const P & b)
+    {
+        const promoted_type dx = promoted_type(a.x) - promoted_type(b.x);
+        const promoted_type dy = promoted_type(a.y) - promoted_type(b.y);
+        return dx * dx + dy * dy;
+    }
+
+    template< typename P >
+    static
+    promoted_type distance(const point & a, const P & b)
+    {
+        using std::sqrt;
+        return sqrt(sqr_distance(a, b));
+    }
+
+    void next_stamp()
+    {
+        if (marks_.size() < points_.size()) {
+            marks_.resize(points_.size(), 0);
+        }
+        ++stamp_;
+    }
+
+    bool mark(const psite i)
+    {
+        return (std::exchange(marks_[i], stamp_) != stamp_);
+    }
+
+    bool marked(const psite i) const
+    {
+        return (marks_[i] == stamp_);
+    }
+
+    void sort_ring(const psite i)
+    {
+        const point & o = points_[i];
+        const auto angle = [&] (const psite n)
+        {
+            using std::atan2;
+            return atan2(promoted_type(points_[n].y) - promoted_type(o.y), promoted_type(points_[n].x) - promoted_type(o.x));
+        };
+        ring & ring_i = rings_[i];
+        std::sort(std::begin(ring_i), std::end(ring_i), [&] (const psite l, const psite r) { return angle(l) < angle(r); });
+    }
+
+    // neighbour of n preceding i in CCW order
+    psite before(const psite n, const psite i) const
+    {
+        const ring & ring_n = rings_[n];
+        const auto it = std::find(std::cbegin(ring_n), std::cend(ring_n), i);
+        assert(it != std::cend(ring_n));
+        return (it == std::cbegin(ring_n)) ? ring_n.back() : *std::prev(it);
+    }
+
+    void unlink(const psite a, const psite b)
+    {
+        for (const auto & ab : {std::make_pair(a, b), std::make_pair(b, a)}) {
+            ring & ring_a = rings_[ab.first];
+            ring_a.erase(std::find(std::begin(ring_a), std::end(ring_a), ab.second));
+        }
+    }
+
+    psite start() const
+    {
+        if (alive(hint_) && !rings_[hint_].empty()) {
+            return hint_;
+        }
+        for (psite i = 0; i < points_.size(); ++i) {
+            if (alive_[i] && !rings_[i].empty()) {
+                return i;
+            }
+        }
+        assert(false);
+        return hint_;
+    }
+
+    // greedy walks over the Delaunay graph reach the nearest site and the extreme site in a direction
+    template< typename P >
+    psite nearest(const P & p, psite i) const
+    {
+        promoted_type d = sqr_distance(points_[i], p);
+        for (bool moved = true; moved;) {
+            moved = false;
+            for (const psite n : rings_[i]) {
+                const promoted_type dn = sqr_distance(points_[n], p);
+                if (dn < d) {
+                    d = dn;
+                    i = n;
+                    moved = true;
+                }
+            }
+        }
+        return i;
+    }
+
+    promoted_type extreme(const promoted_type nx, const promoted_type ny, psite i) const
+    {
+        const auto height = [&] (const psite n) { return nx * promoted_type(points_[n].x) + ny * promoted_type(points_[n].y); };
+        promoted_type h = height(i);
+        for (bool moved = true; moved;) {
+            moved = false;
+            for (const psite n : rings_[i]) {
+                const promoted_type hn = height(n);
+                if (h < hn) {
+                    h = hn;
+                    i = n;
+                    moved = true;
+                }
+            }
+        }
+        return h;
+    }
+
+    // local_ is swept: cells of sorted_, edges refer to them
+    void sweep()
+    {
+        std::sort(std::begin(local_), std::end(local_), [&] (const psite l, const psite r) { return points_[l] < points_[r]; });
+        ids_ = local_;
+        sorted_.clear();
+        for (const psite i : local_) {
+            sorted_.push_back(points_[i]);
+        }
+        sweepline_.clear();
+        sweepline_(sorted_.data(), sorted_.data() + sorted_.size());
+    }
+
+    psite id(const point * const s) const
+    {
+        return ids_[size_type(s - sorted_.data())];
+    }
+
+    void rebuild()
+    {
+        local_.clear();
+        rings_.resize(points_.size());
+        for (psite i = 0; i < points_.size(); ++i) {
+            rings_[i].clear();
+            if (alive_[i]) {
+                local_.push_back(i);
+            }
+        }
+        sweep();
+        for (const auto & edge_ : sweepline_.edges_) {
+            const psite l = id(edge_.l);
+            const psite r = id(edge_.r);
+            rings_[l].push_back(r);
+            rings_[r].push_back(l);
+        }
+        for (const psite i : local_) {
+            sort_ring(i);
+        }
+        if (!local_.empty()) {
+            hint_ = local_.front();
+        }
+        dirty_ = false;
+        changes_ = 0;
+        ++rebuilds;
+    }
+
+    // true if the change should be only recorded
+    bool defer()
+    {
+        if (!dirty_) {
+            ++changes_;
+            if (max_fraction * double(size()) < double(changes_)) {
+                dirty_ = true;
+            }
+        }
+        return dirty_;
+    }
+
+    // k rings of neighbours of q
+    void collect(const psite q, const size_type depth)
+    {
+        next_stamp();
+        local_.assign(1, q);
+        mark(q);
+        size_type b = 0;
+        for (size_type k = 0; k < depth; ++k) {
+            const size_type e = local_.size();
+            for (; b < e; ++b) {
+                const psite i = local_[b];
+                for (const psite n : rings_[i]) {
+                    if (mark(n)) {
+                        local_.push_back(n);
+                    }
+                }
+            }
+        }
+    }
+
+    void place(const psite i, const point & p)
+    {
+        points_[i] = p;
+        alive_[i] = char(true);
+        rings_[i].clear();
+        if (defer()) {
+            return;
+        }
+        if (size() < min_size) {
+            rebuild();
+            return;
+        }
+        const psite q = nearest(p, start());
+        assert(eps_ < distance(points_[q], p));
+        for (size_type depth = 2; ; depth += depth) {
+            collect(q, depth);
+            if (size() < local_.size() + local_.size()) {
+                rebuild();
+                return;
+            }
+            local_.push_back(i);
+            sweep();
+            if (link(i)) {
+                break;
+            }
+        }
+        hint_ = i;
+    }
+
+    // cell of i in the local diagram is the cell in the whole one, if its circles are empty
+    bool check_vertex(const typename sweepline_type::vertex & vertex_, const psite n) const
+    {
+        const psite z = nearest(vertex_.c, n);
+        return !(distance(points_[z], vertex_.c) + promoted_type(eps_) < promoted_type(vertex_.R));
+    }
+
+    // and no site lies beyond its hull edges
+    bool check_ray(const psite i, const psite n) const
+    {
+        const point & a = points_[i];
+        const point & b = points_[n];
+        const promoted_type dx = promoted_type(b.x) - promoted_type(a.x);
+        const promoted_type dy = promoted_type(b.y) - promoted_type(a.y);
+        using std::hypot;
+        const promoted_type length = hypot(dx, dy);
+        for (const psite z : ids_) {
+            const promoted_type h = cross(i, n, points_[z]) / length;
+            if (promoted_type(eps_) < std::abs(h)) { // sites of the local diagram lie on the inner side
+                const promoted_type nx = ((h < 0) ? -dy : dy) / length;
+                const promoted_type ny = ((h < 0) ? dx : -dx) / length;
+                const promoted_type h0 = nx * promoted_type(a.x) + ny * promoted_type(a.y);
+                return !(h0 + promoted_type(eps_) < extreme(nx, ny, n));
+            }
+        }
+        return false; // collinear
+    }
+
+    bool link(const psite i)
+    {
+        ring_.clear();
+        const auto inf = sweepline_.inf;
+        for (const auto & edge_ : sweepline_.edges_) {
+            const psite l = id(edge_.l);
+            const psite r = id(edge_.r);
+            if ((l != i) && (r != i)) {
+                continue;
+            }
+            const psite n = (l == i) ? r : l;
+            for (const auto v : {edge_.b, edge_.e}) {
+                if (v == inf) {
+                    if (!check_ray(i, n)) {
+                        return false;
+                    }
+                } else if (!check_vertex(sweepline_.vertices_[v], n)) {
+                    return false;
+                }
+            }
+            ring_.push_back(n);
+        }
+        next_stamp();
+        for (const psite n : ring_) {
+            mark(n);
+        }
+        removed_.clear();
+        for (const psite a : ring_) {
+            for (const psite b : rings_[a]) {
+                if ((a < b) && marked(b) && !survives(a, b, i)) {
+                    removed_.emplace_back(a, b);
+                }
+            }
+        }
+        for (const auto & ab : removed_) {
+            unlink(ab.first, ab.second);
+        }
+        rings_[i] = ring_;
+        sort_ring(i);
+        for (const psite n : ring_) {
+            rings_[n].push_back(i);
+            sort_ring(n);
+        }
+        return true;
+    }
+
+    struct center
+    {
+
+        promoted_type x, y;
+
+    };
+
+    static
+    center circumcenter(const point & a, const point & b, const point & c)
+    {
+        const promoted_type bx = promoted_type(b.x) - promoted_type(a.x);
+        const promoted_type by = promoted_type(b.y) - promoted_type(a.y);
+        const promoted_type cx = promoted_type(c.x) - promoted_type(a.x);
+        const promoted_type cy = promoted_type(c.y) - promoted_type(a.y);
+        const promoted_type d = promoted_type(2) * (bx * cy - by * cx);
+        const promoted_type B = bx * bx + by * by;
+        const promoted_type C = cx * cx + cy * cy;
+        return {promoted_type(a.x) + (cy * B - by * C) / d, promoted_type(a.y) + (bx * C - cx * B) / d};
+    }
+
+    // part of the edge (a, b), which is nearer to p than to a, is cut off: f(x) = |x - a|^2 - |x - p|^2 is linear along the edge,
+    // the edge survives, if the rest is longer than eps (shorter edges are contracted by the sweep too)
+    bool survives(const psite a, const psite b, const psite p) const
+    {
+        const point & aa = points_[a];
+        const point & pp = points_[p];
+        const auto f = [&] (const center & x)
+        {
+            const promoted_type ax = x.x - promoted_type(aa.x), ay = x.y - promoted_type(aa.y);
+            const promoted_type px = x.x - promoted_type(pp.x), py = x.y - promoted_type(pp.y);
+            return (ax * ax + ay * ay) - (px * px + py * py);
+        };
+        const auto g = [&] (const center & n) // derivative along the unit direction
+        {
+            return promoted_type(2) * (n.x * (promoted_type(pp.x) - promoted_type(aa.x)) + n.y * (promoted_type(pp.y) - promoted_type(aa.y)));
+        };
+        struct end { bool ray; center c; }; // circumcenter or direction of the ray
+        end ends[2];
+        for (const bool k : {false, true}) {
+            const psite l = k ? b : a;
+            const psite r = k ? a : b;
+            const psite c = before(r, l); // face to the left of (l, r)
+            if (cross(l, r, points_[c]) > promoted_type(0)) {
+                ends[k] = {false, circumcenter(points_[l], points_[r], points_[c])};
+            } else {
+                const point & ll = points_[l];
+                const point & rr = points_[r];
+                const promoted_type nx = promoted_type(ll.y) - promoted_type(rr.y);
+                const promoted_type ny = promoted_type(rr.x) - promoted_type(ll.x);
+                using std::hypot;
+                const promoted_type length = hypot(nx, ny);
+                ends[k] = {true, {nx / length, ny / length}};
+            }
+        }
+        const promoted_type eps = eps_;
+        if (ends[0].ray && ends[1].ray) { // line
+            const point & bb = points_[b];
+            const center m = {(promoted_type(aa.x) + promoted_type(bb.x)) / promoted_type(2), (promoted_type(aa.y) + promoted_type(bb.y)) / promoted_type(2)};
+            return (g(ends[0].c) != promoted_type(0)) || (f(m) < promoted_type(0));
+        }
+        if (ends[0].ray || ends[1].ray) {
+            const end & e = ends[0].ray ? ends[1] : ends[0];
+            const promoted_type f0 = f(e.c);
+            const promoted_type d = g((ends[0].ray ? ends[0] : ends[1]).c);
+            if (f0 < promoted_type(0)) {
+                return !(promoted_type(0) < d) || (eps < -f0 / d);
+            }
+            return (d < promoted_type(0));
+        }
+        const promoted_type f0 = f(ends[0].c);
+        const promoted_type f1 = f(ends[1].c);
+        if ((f0 < promoted_type(0)) == (f1 < promoted_type(0))) {
+            return (f0 < promoted_type(0));
+        }
+        using std::hypot;
+        const promoted_type length = hypot(ends[1].c.x - ends[0].c.x, ends[1].c.y - ends[0].c.y);
+        return (eps < length * std::min(f0, f1) / (std::min(f0, f1) - std::max(f0, f1)));
+    }
+
+    void remove(const psite i)
+    {
+        assert(alive(i));
+        alive_[i] = char(false);
+        if (defer()) {
+            return;
+        }
+        if (size() < min_size) {
+            rebuild();
+            return;
+        }
+        // vertices of the faces around i and sectors of these faces at them
+        next_stamp();
+        mark(i);
+        local_.clear();
+        sectors_.clear();
+        const ring & ring_i = rings_[i];
+        for (size_type k = 0; k < ring_i.size(); ++k) {
+            const psite u = ring_i[k];
+            const psite w = ring_i[(k + 1) % ring_i.size()];
+            if (!(cross(i, u, points_[w]) > promoted_type(0))) {
+                continue; // outer face
+            }
+            psite prev = i;
+            psite cur = u;
+            while (cur != i) {
+                const psite c = before(cur, prev);
+                sectors_.push_back({cur, c, prev});
+                if (mark(cur)) {
+                    local_.push_back(cur);
+                }
+                prev = std::exchange(cur, c);
+            }
+        }
+        for (const psite n : ring_i) {
+            ring & ring_n = rings_[n];
+            ring_n.erase(std::find(std::begin(ring_n), std::end(ring_n), i));
+        }
+        if (sectors_.empty()) { // no inner face: neighbours are collinear with i (at most two, on both sides of it), they become neighbours
+            if (ring_i.size() == 2) {
+                const psite u = ring_i.front();
+                const psite w = ring_i.back();
+                rings_[u].push_back(w);
+                rings_[w].push_back(u);
+                sort_ring(u);
+                sort_ring(w);
+            }
+            hint_ = ring_i.empty() ? start() : ring_i.front();
+            rings_[i].clear();
+            return;
+        }
+        rings_[i].clear();
+        sweep();
+        for (const auto & edge_ : sweepline_.edges_) {
+            const psite l = id(edge_.l);
+            const psite r = id(edge_.r);
+            ring & ring_l = rings_[l];
+            if (std::find(std::cbegin(ring_l), std::cend(ring_l), r) != std::cend(ring_l)) {
+                continue;
+            }
+            if (inside(l, r, i)) {
+                ring_l.push_back(r);
+                rings_[r].push_back(l);
+            }
+        }
+        for (const psite n : local_) {
+            sort_ring(n);
+        }
+        hint_ = local_.empty() ? start() : local_.front();
+    }
+
+    // the edge (a, b) leaves a into the hole of i
+    bool inside(const psite a, const psite b, const psite i) const
+    {
+        const point & bb = points_[b];
+        for (const sector & sector_ : sectors_) {
+            if (sector_.s != a) {
+                continue;
+            }
+            const promoted_type l = cross(a, sector_.l, bb);
+            const promoted_type r = cross(a, sector_.r, bb);
+            if ((promoted_type(0) < l) && (r < promoted_type(0))) {
+                return true;
+            }
+            if (((sector_.l == i) && !(l < promoted_type(0)) && !(promoted_type(0) < l)) ||
+                ((sector_.r == i) && !(r < promoted_type(0)) && !(promoted_type(0) < r))) { // through i
+                const point & aa = points_[a];
+                const point & ii = points_[i];
+                if (promoted_type(0) < (promoted_type(bb.x) - promoted_type(aa.x)) * (promoted_type(ii.x) - promoted_type(aa.x))
+                                     + (promoted_type(bb.y) - promoted_type(aa.y)) * (promoted_type(ii.y) - promoted_type(aa.y))) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+};
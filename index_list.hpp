@@ -0,0 +1,132 @@
+#pragma once
+
+#include <utility>
+#include <memory>
+#include <vector>
+#include <limits>
+
+#include <cassert>
+#include <cstdint>
+
+namespace index_list
+{
+
+// doubly linked list of values stored contiguously, nodes are addressed by indices
+// nodes are never freed, except by clear(), so a free list can be maintained by splicing them to the end
+// 0 is an index of the sentinel node: end()
+template< typename type,
+          typename index = std::uint32_t,
+          typename allocator = std::allocator< type > >
+struct list
+{
+
+    using size_type = index;
+    using value_type = type;
+    using allocator_type = allocator;
+
+private :
+
+    struct node
+    {
+
+        type value;
+        index p, n;
+
+    };
+
+    using node_allocator_type = typename std::allocator_traits< allocator >::template rebind_alloc< node >;
+
+    std::vector< node, node_allocator_type > nodes;
+
+    void link(const index pos, const index i) noexcept
+    {
+        node & s = nodes[i];
+        s.n = pos;
+        s.p = std::exchange(nodes[pos].p, i);
+        nodes[s.p].n = i;
+    }
+
+    void unlink(const index f, const index l) noexcept // [f, l]
+    {
+        nodes[nodes[f].p].n = nodes[l].n;
+        nodes[nodes[l].n].p = nodes[f].p;
+    }
+
+public :
+
+    explicit
+    list(const allocator_type & alloc = allocator_type{})
+        : nodes(1, node{{}, 0, 0}, alloc)
+    { ; }
+
+    size_type size() const noexcept { return size_type(nodes.size() - 1); }
+
+    bool empty() const noexcept { return (nodes.size() == 1); }
+
+    void reserve(const size_type n)
+    {
+        nodes.reserve(std::size_t(n) + 1);
+    }
+
+    // memory taken by reserve(n) of an empty list
+    static constexpr std::size_t reserved_bytes(const size_type n) noexcept
+    {
+        return (std::size_t(n) + 1) * sizeof(node);
+    }
+
+    void clear() noexcept
+    {
+        nodes.resize(1);
+        nodes.front().p = nodes.front().n = 0;
+    }
+
+    void shrink_to_fit()
+    {
+        nodes.shrink_to_fit();
+    }
+
+    index begin() const noexcept { return nodes.front().n; }
+    index end() const noexcept { return 0; }
+
+    index next(const index i) const noexcept { return nodes[i].n; }
+    index prev(const index i) const noexcept { return nodes[i].p; }
+
+    type & operator [] (const index i) noexcept { assert(i != 0); return nodes[i].value; }
+    const type & operator [] (const index i) const noexcept { assert(i != 0); return nodes[i].value; }
+
+    // new node is always placed at the end of the storage
+    index insert(const index pos, const type & value)
+    {
+        assert(nodes.size() < std::size_t(std::numeric_limits< index >::max()));
+        const auto i = index(nodes.size());
+        nodes.push_back({value, 0, 0});
+        link(pos, i);
+        return i;
+    }
+
+    void splice(const index pos, const index i) noexcept
+    {
+        if ((pos != i) && (nodes[i].n != pos)) {
+            unlink(i, i);
+            link(pos, i);
+        }
+    }
+
+    // move [f, l) before pos, pos can not be in [f, l)
+    void splice(const index pos, const index f, const index l) noexcept
+    {
+        if ((f == l) || (l == pos)) {
+            return;
+        }
+        const index b = nodes[l].p;
+        unlink(f, b);
+        const index p = nodes[pos].p;
+        nodes[p].n = f;
+        nodes[f].p = p;
+        nodes[b].n = pos;
+        nodes[pos].p = b;
+    }
+
+};
+
+}
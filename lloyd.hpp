@@ -0,0 +1,195 @@
+#pragma once
+
+#include "box_clip.hpp"
+#include "site_sort.hpp"
+#include "thread_pool.hpp"
+
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <vector>
+
+#include <cassert>
+#include <cstddef>
+#include <cmath>
+
+// Lloyd relaxation (centroidal Voronoi tessellation) in the rectangle [vmin, vmax]: every iteration sweeps the sites into a dcel,
+// clips each cell by the rectangle and moves the site to the centroid of its polygon in the same pass (on a thread_pool, if any).
+// The sites are kept in (x, y) order: they move a little between iterations, so the almost sorted array is re-sorted by insertion sort,
+// which falls back to radix sort, once the number of moves exceeds max_moves per site. The dcel, the sweepline pools, the clipping buffers,
+// the centroids and the buffers of the radix sort are reused, so iterations do not allocate once they are warm.
+// Sites should lie in the rectangle (a site, which cell misses it, stays in place), distances between them should exceed eps.
+// Columns of a grid are not kept straight: x of their sites scatter by a few ulps, which the sweep does not support (x within eps, y not in order).
+template< typename point,
+          typename value_type = decltype(std::declval< point >().x) >
+struct lloyd
+{
+
+    using size_type = std::size_t;
+    using site = const point *;
+    using dcel_type = dcel< site, value_type >;
+    using box_clip_type = box_clip< site, value_type >;
+    using vertex_point = typename dcel_type::vertex_point;
+    using sweepline_type = dcel_sweepline< site, point, value_type >;
+
+    lloyd(value_type eps, const vertex_point & vmin, const vertex_point & vmax)
+        : dcel_{nullptr, 0}
+        , sweepline_{std::move(eps), dcel_.make_sink()}
+        , clips_(1, box_clip_type{vmin, vmax})
+    { ; }
+
+    lloyd(value_type eps, const vertex_point & vmin, const vertex_point & vmax, thread_pool & pool)
+        : pool_{&pool}
+        , dcel_{nullptr, 0}
+        , sweepline_{std::move(eps), dcel_.make_sink()}
+        , clips_(pool.size(), box_clip_type{vmin, vmax})
+    { ; }
+
+    lloyd(const lloyd &) = delete; // the sink refers to dcel_
+    lloyd(lloyd &&) = delete;
+    void operator = (const lloyd &) = delete;
+    void operator = (lloyd &&) = delete;
+
+    size_type max_moves = 8; // per site, for insertion sort
+    size_type block_size = 1024; // cells per job of the parallel pass
+
+    size_type resorts = 0; // radix sorts after the first one
+
+    template< typename iterator >
+    void assign(iterator first, const iterator last)
+    {
+        points_.assign(first, last);
+        site_sort::radix_permutation(std::cbegin(points_), std::cend(points_), indices_);
+        site_sort::apply_permutation(std::begin(points_), indices_);
+    }
+
+    // the largest displacement of a site during the last iteration
+    value_type operator () (const size_type iterations = 1)
+    {
+        value_type max_shift{0};
+        for (size_type i = 0; i < iterations; ++i) {
+            max_shift = step();
+        }
+        return max_shift;
+    }
+
+    // f(i, p) for i-th site of assign() at its current position p
+    template< typename F >
+    void for_each_site(F && f) const
+    {
+        const size_type n = points_.size();
+        for (size_type j = 0; j < n; ++j) {
+            f(indices_[j], points_[j]);
+        }
+    }
+
+private :
+
+    thread_pool * const pool_ = nullptr;
+
+    std::vector< point > points_; // in (x, y) order
+    std::vector< size_type > indices_; // points_[j] is the indices_[j]-th site of assign()
+    std::vector< size_type > permutation_;
+    site_sort::scratch< point, size_type > scratch_; // buffers of the re-sort
+    std::vector< point > sorted_points_;
+    std::vector< size_type > sorted_indices_;
+    std::vector< vertex_point > centroids_;
+
+    dcel_type dcel_;
+    sweepline_type sweepline_;
+    std::vector< box_clip_type > clips_; // per worker
+
+    // signed area is accumulated relative to the site for the sake of precision
+    static vertex_point centroid(const std::vector< vertex_point > & polygon, const point & s)
+    {
+        const size_type n = polygon.size();
+        value_type A{0}, X{0}, Y{0};
+        for (size_type i = 0; i < n; ++i) {
+            const vertex_point & a = polygon[i];
+            const vertex_point & b = polygon[(i + 1 == n) ? 0 : (i + 1)];
+            const value_type ax = a.x - s.x, ay = a.y - s.y;
+            const value_type bx = b.x - s.x, by = b.y - s.y;
+            const value_type cross = ax * by - ay * bx;
+            A += cross;
+            X += (ax + bx) * cross;
+            Y += (ay + by) * cross;
+        }
+        if (!(value_type(0) < A)) {
+            return {s.x, s.y};
+        }
+        A *= value_type(3);
+        return {s.x + X / A, s.y + Y / A};
+    }
+
+    void centroids(box_clip_type & clip_, const size_type l, const size_type r)
+    {
+        for (size_type c = l; c < r; ++c) {
+            centroids_[c] = centroid(clip_.clip_cell(dcel_, c), points_[c]);
+        }
+    }
+
+    // false, if it took more than budget moves: points_ are kept, but not sorted then
+    bool insertion_sort(size_type budget)
+    {
+        const size_type n = points_.size();
+        for (size_type i = 1; i < n; ++i) {
+            if (!(points_[i] < points_[i - 1])) {
+                continue;
+            }
+            const point p = points_[i];
+            const size_type k = indices_[i];
+            size_type j = i;
+            do {
+                points_[j] = points_[j - 1];
+                indices_[j] = indices_[j - 1];
+            } while ((0 < --j) && (p < points_[j - 1]));
+            points_[j] = p;
+            indices_[j] = k;
+            if (budget < i - j) {
+                return false;
+            }
+            budget -= i - j;
+        }
+        return true;
+    }
+
+    value_type step()
+    {
+        const size_type n = points_.size();
+        if (n == 0) {
+            return value_type(0);
+        }
+        const site first = points_.data();
+        dcel_.reset(first, n);
+        sweepline_.clear();
+        sweepline_(first, first + n);
+        centroids_.resize(n);
+        if (pool_ && (block_size < n)) {
+            const size_type blocks = (n + block_size - 1) / block_size;
+            pool_->parallel_for(blocks, [this, n] (const size_type b, const size_type w)
+            {
+                centroids(clips_[w], b * block_size, std::min(n, (b + 1) * block_size));
+            });
+        } else {
+            centroids(clips_.front(), 0, n);
+        }
+        value_type max_shift2{0};
+        for (size_type c = 0; c < n; ++c) {
+            point & p = points_[c];
+            const vertex_point & g = centroids_[c];
+            const value_type dx = g.x - p.x, dy = g.y - p.y;
+            max_shift2 = std::max(max_shift2, dx * dx + dy * dy);
+            p.x = g.x;
+            p.y = g.y;
+        }
+        if (!insertion_sort(max_moves * n)) {
+            site_sort::radix_permutation(std::cbegin(points_), std::cend(points_), permutation_, scratch_);
+            site_sort::apply_permutation(std::begin(points_), permutation_, sorted_points_);
+            site_sort::apply_permutation(std::begin(indices_), permutation_, sorted_indices_);
+            ++resorts;
+        }
+        using std::sqrt;
+        return sqrt(max_shift2);
+    }
+
+};
@@ -1,650 +1,4 @@
-#include "sweepline.hpp"
-
-#include <utility>
-#include <limits>
-#include <iterator>
-#include <algorithm>
-#include <random>
-#include <tuple>
-#include <set>
-#include <vector>
-#include <iomanip>
-#include <istream>
-#include <ostream>
-#include <sstream>
-
-#include <cassert>
-#include <cmath>
-
-template< typename iterator >
-struct proxy_iterator
-{
-
-    using iterator_type     = typename std::iterator_traits< iterator >::value_type;
-    using iterator_traits   = std::iterator_traits< iterator_type >;
-
-    using iterator_category = std::forward_iterator_tag;
-    using value_type        = typename iterator_traits::value_type;
-    using difference_type   = typename iterator_traits::difference_type;
-    using pointer           = typename iterator_traits::pointer;
-    using reference         = typename iterator_traits::reference;
-
-    iterator it;
-
-    operator iterator_type () const { return *it; }
-
-    proxy_iterator & operator ++ () { ++it; return *this; }
-    const proxy_iterator operator ++ (int) { return {it++}; }
-
-    reference operator * () const { return **it; }
-    pointer operator -> () const { return &operator * (); }
-
-    bool operator == (const proxy_iterator pi) const { return (it == pi.it); }
-    bool operator != (const proxy_iterator pi) const { return (it != pi.it); }
-
-};
-
-template< typename point, typename value_type = decltype(std::declval< point >().x) >
-struct voronoi
-{
-
-    using size_type = std::size_t;
-
-    bool draw_indices = false;
-    bool draw_circles = false;
-
-    const value_type zero = value_type(0);
-    const value_type one = value_type(1);
-
-    const value_type eps2 = one / value_type(1 << 24);
-    const value_type eps = [&] { using std::sqrt; return sqrt(eps2); }();
-    const value_type delta = value_type(0.001);
-
-    std::ostream & log_;
-
-    explicit
-    voronoi(std::ostream & _log)
-        : log_(_log)
-    {
-        assert(!(delta < eps));
-        log_ << "eps = " << eps << '\n';
-        log_ << "delta = " << delta << '\n';
-    }
-
-private :
-
-    std::mt19937_64 rng;
-    std::normal_distribution< value_type > normal_;
-    std::uniform_real_distribution< value_type > zero_to_one_{zero, std::nextafter(one, one + one)};
-
-public :
-
-    using seed_type = typename std::mt19937_64::result_type;
-
-    void seed(const seed_type seed)
-    {
-        log_ << "seed = " << seed << '\n';
-        rng.seed(seed);
-    }
-
-    struct less
-    {
-
-        const value_type & eps;
-
-        bool operator () (const value_type & l,
-                          const value_type & r) const
-        {
-            return l + eps < r;
-        }
-
-        bool operator () (const value_type & lx, const value_type & ly,
-                          const value_type & rx, const value_type & ry) const
-        {
-            if (operator () (lx, rx)) {
-                return true;
-            } else if (operator () (rx, lx)) {
-                return false;
-            } else {
-                return operator () (ly, ry);
-            }
-        }
-
-        bool operator () (const point & l, const point & r) const
-        {
-            return operator () (l.x, l.y, r.x, r.y);
-        }
-
-    };
-
-    void ball(std::ostream & _out, const value_type radius, const size_type N)
-    {
-        std::set< point, less > unique_points_{less{delta}};
-        _out << N << '\n';
-        constexpr size_type M = 1000; // number of attempts
-        for (size_type n = 0; n < N; ++n) { // points that are uniformely distributed inside of closed ball
-            size_type m = 0;
-            do {
-                point p{normal_(rng), normal_(rng)};
-                value_type norm = p.x * p.x + p.y * p.y;
-                if (eps2 < norm) {
-                    using std::sqrt;
-                    norm = radius * sqrt(zero_to_one_(rng) / std::move(norm));
-                    p.x *= norm;
-                    p.y *= norm;
-                } else {
-                    p.x = p.y = zero;
-                }
-                if (unique_points_.insert(std::move(p)).second) {
-                    break;
-                }
-            } while (++m < M);
-            if (m == M) {
-                log_ << "the number (" << M << ") of attempts is exceeded\n";
-                log_ << "only " << n << "points generated\n";
-                break;
-            }
-        }
-        for (const point & point_ : unique_points_) {
-            _out << point_.x << ' ' << point_.y << '\n';
-        }
-    }
-
-    void gauss(std::ostream & _out, const value_type dispersion, const size_type N)
-    {
-        std::set< point, less > unique_points_{less{delta}};
-        _out << N << '\n';
-        constexpr size_type M = 1000; // number of attempts
-        for (size_type n = 0; n < N; ++n) { // points that are uniformely distributed inside of closed ball
-            size_type m = 0;
-            do {
-                point p{normal_(rng) * dispersion, normal_(rng) * dispersion};
-                if (unique_points_.insert(std::move(p)).second) {
-                    break;
-                }
-            } while (++m < M);
-            if (m == M) {
-                log_ << "the number (" << M << ") of attempts is exceeded\n";
-                log_ << "only " << n << "points generated\n";
-                break;
-            }
-        }
-        for (const point & point_ : unique_points_) {
-            _out << point_.x << ' ' << point_.y << '\n';
-        }
-    }
-
-    void square(std::ostream & _out, const value_type bbox, const size_type N)
-    {
-        std::set< point, less > unique_points_{less{delta}};
-        _out << N << '\n';
-        constexpr size_type M = 1000; // number of attempts
-        for (size_type n = 0; n < N; ++n) { // points that are uniformely distributed inside of closed square
-            size_type m = 0;
-            do {
-                point p{zero_to_one_(rng), zero_to_one_(rng)};
-                p.x += p.x;
-                p.y += p.y;
-                p.x -= one;
-                p.y -= one;
-                p.x *= bbox;
-                p.y *= bbox;
-                if (unique_points_.insert(std::move(p)).second) {
-                    break;
-                }
-            } while (++m < M);
-            if (m == M) {
-                log_ << "the number (" << M << ") of attempts is exceeded\n";
-                log_ << "only " << n << "points generated\n";
-                break;
-            }
-        }
-        for (const point & point_ : unique_points_) {
-            _out << point_.x << ' ' << point_.y << '\n';
-        }
-    }
-
-    void rectangular_grid(std::ostream & _out, const size_type bbox) const
-    {
-        const size_type N = 1 + 4 * bbox * (bbox + 1);
-        _out << N << '\n';
-        _out << "0 0\n";
-        for (size_type x = 1; x <= bbox; ++x) {
-            _out << "0 " << x << '\n';
-            _out << x << " 0\n";
-            _out << "0 -" << x << '\n';
-            _out << '-' << x << " 0\n";
-            for (size_type y = 1; y <= bbox; ++y) {
-                _out << x << ' ' << y << '\n';
-                _out << '-' << x << ' ' << y << '\n';
-                _out << x << " -" << y << '\n';
-                _out << '-' << x << " -" << y << '\n';
-            }
-        }
-    }
-
-    void diagonal_grid(std::ostream & _out, const size_type bbox) const
-    {
-        const size_type N = (1 + 2 * bbox * (bbox + 1));
-        _out << N << '\n';
-        _out << "0 0\n";
-        size_type i = 1;
-        for (size_type x = 1; x <= bbox; ++x) {
-            for (size_type y = x % 2; y <= bbox; y += 2) {
-                _out << x << ' ' << y << '\n';
-                _out << y << " -" << x << '\n';
-                _out << '-' << x << " -" << y << '\n';
-                _out << '-' << y << ' ' << x << '\n';
-                i += 4;
-            }
-        }
-        assert(N == i);
-    }
-
-    void hexagonal_grid(std::ostream & _out, const size_type size) const
-    {
-        const size_type N = (size + size) * (size + 1);
-        _out << N << '\n';
-        using std::sqrt;
-        const value_type step = sqrt(value_type(3));
-        size_type i = 0;
-        for (size_type x = 1; x <= size; ++x) {
-            const value_type xx = value_type(x) * step;
-            if ((x % 2) == 0) {
-                const value_type yy = value_type(3 * (x - 1));
-                _out << "0 " << yy << '\n';
-                _out << "0 -" << yy << '\n';
-            } else {
-                _out << xx << " 0\n";
-                _out << '-' << xx << " 0\n";
-            }
-            i += 2;
-            for (size_type y = 1 + (x % 2); y <= size; y += 2) {
-                const size_type yy = 3 * y;
-                _out << xx << ' ' << yy << '\n';
-                _out << xx << " -" << yy << '\n';
-                _out << '-' << xx << ' ' << yy << '\n';
-                _out << '-' << xx << " -" << yy << '\n';
-                i += 4;
-            }
-        }
-        if ((size % 2) != 0) {
-            const value_type yy = value_type(3 * size);
-            _out << "0 " << yy << '\n';
-            _out << "0 -" << yy << '\n';
-            i += 2;
-        }
-        assert(i == N);
-    }
-
-    void triangular_grid(std::ostream & _out, const size_type size) const
-    {
-        const size_type N = (1 + size + size) * (size + size);
-        _out << N << '\n';
-        using std::sqrt;
-        const value_type step = sqrt(value_type(3));
-        size_type i = 0;
-        for (size_type x = 1; x <= size; ++x) {
-            const size_type xx = 3 * x;
-            {
-                const value_type yy = value_type(step) * (xx - 1 - (x % 2));
-                _out << "0 " << yy << '\n';
-                _out << "0 -" << yy << '\n';
-            }
-            i += 2;
-            for (size_type y = 1; y <= size; ++y) {
-                const value_type yy = step * value_type(3 * y - 1 - ((y + x) % 2));
-                _out << xx << ' ' << yy << '\n';
-                _out << xx << " -" << yy << '\n';
-                _out << '-' << xx << ' ' << yy << '\n';
-                _out << '-' << xx << " -" << yy << '\n';
-                i += 4;
-            }
-        }
-        assert(i == N);
-    }
-
-    struct ipoint { size_type x, y; };
-
-    template< std::size_t nsqr >
-    void quadrant(std::ostream & _out, const size_type max, const ipoint (& q)[nsqr]) const
-    {
-        if (0 == max) {
-            _out << (nsqr * 8) << '\n';
-        } else {
-            _out << (nsqr * 8 + 4) << '\n';
-            _out << "0 " << max << '\n';
-            _out << "0 -" << max << '\n';
-            _out << max << " 0\n";
-            _out << '-' << max << " 0\n";
-        }
-        const auto qprint = [&] (const bool swap, const bool sx, const bool sy)
-        {
-            for (const ipoint & p : q) {
-                assert(p.x != 0);
-                assert(p.y != 0);
-                if (sx) {
-                    _out << '-';
-                }
-                _out << (swap ? p.x : p.y) << ' ';
-                if (sy) {
-                    _out << '-';
-                }
-                _out << (swap ? p.y : p.x) << '\n';
-            }
-        };
-        qprint(true,  true,  true);
-        qprint(true,  false, true);
-        qprint(true,  true,  false);
-        qprint(true,  false, false);
-        qprint(false, true,  true);
-        qprint(false, false, true);
-        qprint(false, true,  false);
-        qprint(false, false, false);
-    }
-
-    using points = std::vector< point >;
-
-private :
-
-    points points_;
-
-    void input(std::istream & _in)
-    {
-        size_type M = 0;
-        if (!(_in >> M)) {
-            assert(false);
-        }
-        points_.reserve(M);
-        for (size_type m = 0; m < M; ++m) {
-            points_.emplace_back();
-            point & point_ = points_.back();
-            if (!(_in >> point_)) {
-                assert(false);
-            }
-        }
-    }
-
-public :
-
-    friend
-    std::istream & operator >> (std::istream & _in, voronoi & _voronoi)
-    {
-        _voronoi.input(_in);
-        return _in;
-    }
-
-    void swap_xy()
-    {
-        for (point & point_ : points_) {
-            using std::swap;
-            swap(point_.x, point_.y);
-        }
-    }
-
-    void shift_xy(const value_type & dx, const value_type & dy)
-    {
-        for (point & point_ : points_) {
-            point_.x += dx;
-            point_.y += dy;
-        }
-    }
-
-    void rotate(const value_type & angle)
-    {
-        using std::cos;
-        using std::sqrt;
-        const value_type cosine = cos(angle);
-        const value_type sine = sqrt(one - cosine * cosine);
-        for (point & point_ : points_) {
-            point_.rotate(cosine, sine);
-        }
-    }
-
-    using site = typename points::const_iterator;
-
-    using sweepline_type = sweepline< site, point, value_type >;
-
-    sweepline_type sweepline_{eps};
-
-    void operator () ()
-    {
-        assert((std::set< point, less >{std::cbegin(points_), std::cend(points_), less{delta}}.size() == points_.size()));
-        log_ << "N = " << points_.size() << '\n';
-#if 0
-        std::sort(std::begin(points_), std::end(points_));
-        sweepline_(std::cbegin(points_), std::cend(points_));
-#else
-        using sites = std::vector< site >;
-        sites sites_;
-        {
-            sites_.reserve(points_.size() + 1);
-            const auto send = std::cend(points_);
-            for (auto s = std::cbegin(points_); s != send; ++s) {
-                sites_.push_back(s);
-            }
-            const auto sless = [] (const site l, const site r) -> bool { return *l < *r; };
-            std::sort(std::begin(sites_), std::end(sites_), sless);
-            sites_.push_back(send);
-        }
-        using psite = proxy_iterator< typename sites::const_iterator >;
-        sweepline_(psite{std::cbegin(sites_)}, psite{std::prev(std::cend(sites_))});
-#ifndef NDEBUG
-        using vpoints_type = std::vector< size_type >;
-        const size_type vsize = sweepline_.vertices_.size();
-        vpoints_type heads(vsize);
-        vpoints_type tails(vsize);
-        for (const auto & edge_ : sweepline_.edges_) {
-            if (edge_.b != sweepline_.inf) {
-                ++heads[edge_.b];
-            }
-            if (edge_.e != sweepline_.inf) {
-                ++tails[edge_.e];
-            }
-        }
-        using pvertex = typename sweepline_type::pvertex;
-        for (pvertex v = 0; v < vsize; ++v) {
-            const size_type b = heads[v];
-            assert(0 < b);
-            assert(2 < tails[v] + b);
-        }
-#endif
-#endif
-    }
-
-    struct truncate_edge
-    {
-
-        const point & l;
-        const point & r;
-        const point & b;
-
-        const point & vmin;
-        const point & vmax;
-
-        const value_type & eps_;
-
-        const value_type dx = r.y - l.y; // +pi/2 rotation (dy, -dx)
-        const value_type dy = l.x - r.x;
-
-        point px(const value_type & y) const { return {(b.x + (y - b.y) * dx / dy), y}; }
-
-        point py(const value_type & x) const
-        {
-            const value_type y = b.y + (x - b.x) * dy / dx;
-            if (+eps_ < dy) {
-                if (vmax.y < y) {
-                    return px(vmax.y);
-                }
-            } else if (dy < -eps_) {
-                if (y < vmin.y) {
-                    return px(vmin.y);
-                }
-            }
-            return {x, y};
-        }
-
-        operator point () const // e
-        {
-            if (+eps_ < dx) {
-                return py(vmax.x);
-            } else if (dx < -eps_) {
-                return py(vmin.x);
-            } else {
-                if (+eps_ < dy) {
-                    return {b.x, vmax.y};
-                } else if (dy < -eps_) {
-                    return {b.x, vmin.y};
-                } else {
-                    assert(false);
-                    return {b.x, b.y};
-                }
-            }
-        }
-
-    };
-
-    value_type zoom = value_type(0.2);
-
-    template< typename V, typename E >
-    void output(std::ostream & _gnuplot,
-                const V & _vertices,
-                const E & _edges) const
-    {
-        if (points_.empty()) {
-            _gnuplot << "print 'no point to process'\n;";
-            return;
-        }
-        // pmin, pmax denotes bounding box
-        point vmin = points_.front();
-        point vmax = vmin;
-        const auto pminmax = [&] (const point & p)
-        {
-            if (p.x < vmin.x) {
-                vmin.x = p.x;
-            } else if (vmax.x < p.x) {
-                vmax.x = p.x;
-            }
-            if (p.y < vmin.y) {
-                vmin.y = p.y;
-            } else if (vmax.y < p.y) {
-                vmax.y = p.y;
-            }
-        };
-        std::for_each(std::next(std::cbegin(points_)), std::cend(points_), pminmax);
-        assert(value_type(-0.5) < zoom);
-        if (vmin.x + delta < vmax.x) {
-            value_type dx = vmax.x - vmin.x;
-            dx *= zoom;
-            vmin.x -= dx;
-            vmax.x += dx;
-        } else {
-            vmin.x -= delta;
-            vmax.x += delta;
-        }
-        if (vmin.y + delta < vmax.y) {
-            value_type dy = vmax.y - vmin.y;
-            dy *= zoom;
-            vmin.y -= dy;
-            vmax.y += dy;
-        } else {
-            vmin.y -= delta;
-            vmax.y += delta;
-        }
-        point pmin = vmin;
-        point pmax = vmax;
-        std::for_each(std::cbegin(_vertices), std::cend(_vertices), [&] (const auto & v) { pminmax(v.c); });
-        {
-            _gnuplot << "set title"
-                        " 'sites #" << points_.size()
-                     << ", vertices #" << _vertices.size()
-                     << ", edges #" << _edges.size() << "';\n";
-            _gnuplot << "set size square;\n"
-                        "set key left;\n"
-                        "unset colorbox;\n"
-                        "set cbrange [-1:1];\n";
-            _gnuplot << "set xrange [" << pmin.x << ':' << pmax.x << "];\n";
-            _gnuplot << "set yrange [" << pmin.y << ':' << pmax.y << "];\n";
-            _gnuplot << "set size ratio -1;\n";
-        }
-        {
-            _gnuplot << "$sites << EOI\n";
-            size_type i = 0;
-            for (const point & point_ : points_) {
-                _gnuplot << point_.x << ' ' << point_.y << ' ' << i++ << '\n';
-            }
-            _gnuplot << "EOI\n";
-        }
-        {
-            _gnuplot << "$circles << EOI\n";
-            if (draw_circles) {
-                size_type i = 0;
-                for (const auto & vertex_ : _vertices) {
-                    _gnuplot << vertex_.c.x << ' ' << vertex_.c.y << ' ' << vertex_.R << ' ' << i++ << '\n';
-                }
-            }
-            _gnuplot << "EOI\n";
-        }
-        {
-            _gnuplot << "$edges << EOI\n";
-            if (!_edges.empty()) {
-                const auto pout = [&] (const point & p)
-                {
-                    _gnuplot << p.x << ' ' << p.y << '\n';
-                };
-                const auto inf = sweepline_.inf;
-                for (const auto & edge_ : _edges) {
-                    const bool beg = (edge_.b != inf);
-                    const bool end = (edge_.e != inf);
-                    const point & l = *edge_.l;
-                    const point & r = *edge_.r;
-                    if (beg != end) {
-                        const point & p = _vertices[beg ? edge_.b : edge_.e].c;
-                        if (!(p.x < vmin.x) && !(vmax.x < p.x) && !(p.y < vmin.y) && !(vmax.y < p.y)) {
-                            pout(p);
-                            pout(truncate_edge{(beg ? l : r), (end ? l : r), p, vmin, vmax, eps});
-                        }
-                    } else if (beg) {
-                        assert(!less{eps}(_vertices[edge_.e].c, _vertices[edge_.b].c));
-                        pout(_vertices[edge_.b].c);
-                        pout(_vertices[edge_.e].c);
-                    } else {
-                        const point p{(l.x + r.x) / value_type(2), (l.y + r.y) / value_type(2)};
-                        pout(truncate_edge{l, r, p, vmin, vmax, eps});
-                        pout(truncate_edge{r, l, p, vmin, vmax, eps});
-                    }
-                    _gnuplot << "\n"; // separate lines
-                }
-            }
-            _gnuplot << "EOI\n";
-        }
-        _gnuplot << "plot";
-        _gnuplot << " '$sites' with points title 'sites'";
-        if (draw_indices) {
-            _gnuplot << ", '' with labels offset character 0, character 1 notitle";
-        }
-        _gnuplot << ", '$edges' with lines title 'edges'";
-        _gnuplot << ", '$circles' with circles title 'vertices' linecolor palette";
-        _gnuplot << ";\n";
-    }
-
-private :
-
-    void output(std::ostream & _out) const
-    {
-        return output(_out, sweepline_.vertices_, sweepline_.edges_);
-    }
-
-public :
-
-    friend
-    std::ostream & operator << (std::ostream & _gnuplot, const voronoi & _voronoi)
-    {
-        _voronoi.output(_gnuplot);
-        return _gnuplot;
-    }
-
-};
+#include "voronoi.hpp"
 
 #include <iterator>
 #include <algorithm>
@@ -664,7 +18,6 @@ public :
 
 #include <cstdlib>
 
-#include <x86intrin.h>
 #include <cxxabi.h>
 
 #define RED(str) __extension__ "\e[1;31m" str "\e[0m"
@@ -701,35 +54,7 @@ get_demangled_name(const char * const symbol) noexcept
 
 using value_type = double;
 
-struct alignas(__m128d) point
-{
-
-    value_type x, y;
-
-    bool operator < (const point & p) const
-    {
-        return std::tie(x, y) < std::tie(p.x, p.y);
-    }
-
-    void rotate(const value_type & cosine,
-                const value_type & sine)
-    {
-        value_type z = cosine * x - sine * y;
-        y = sine * x + cosine * y;
-        x = z;
-    }
-
-    friend std::istream & operator >> (std::istream & in, point & p)
-    {
-        return in >> p.x >> p.y;
-    }
-
-    friend std::ostream & operator << (std::ostream & out, const point & p)
-    {
-        return out << p.x << ' ' << p.y;
-    }
-
-};
+using point = plane_point< value_type >;
 
 int main()
 {
@@ -0,0 +1,537 @@
+#pragma once
+
+#include "sweepline.hpp"
+#include "thread_pool.hpp"
+
+#include <type_traits>
+#include <tuple>
+#include <functional>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include <cassert>
+#include <cmath>
+
+// Divide and conquer over vertical strips of x-sorted sites
+// Every strip is swept independently with a halo of neighbouring sites. Vertex is owned by the strip,
+// whose core contains the least (in sorted order) site of the vertex, then ownership does not depend on rounding.
+// Vertex is owned only if its circle contains no site outside of the window (core and halo), i.e. it is a vertex of the whole diagram.
+// Edges between vertices owned by the same strip are taken as is. Seam edges are stitched by the pairs of their sites,
+// unmatched ones should be rays along the convex hull. Otherwise some vertex is missing: halos of the strips,
+// which should see it, are doubled and these strips are swept again. If the window is already full, then serial sweep is performed.
+template< typename site,
+          typename point = typename std::iterator_traits< site >::value_type,
+          typename value_type = decltype(std::declval< point >().x),
+          typename event_queue = tree_event_queue >
+struct parallel_sweepline
+{
+
+    static_assert(std::is_base_of< std::random_access_iterator_tag, typename std::iterator_traits< site >::iterator_category >::value,
+                  "sites should be stored in an array");
+
+    using sweepline_type = sweepline< site, point, value_type, event_queue >;
+
+    using size_type = typename sweepline_type::size_type;
+    using vertex = typename sweepline_type::vertex;
+    using vertices = typename sweepline_type::vertices;
+    using pvertex = typename sweepline_type::pvertex;
+    using edge = typename sweepline_type::edge;
+    using edges = typename sweepline_type::edges;
+    using pedge = typename sweepline_type::pedge;
+
+    parallel_sweepline(value_type eps, thread_pool & _pool)
+        : eps_{std::move(eps)}
+        , pool_(_pool)
+    {
+        assert(!(eps_ < value_type(0)));
+    }
+
+    vertices vertices_;
+    const pvertex inf = std::numeric_limits< pvertex >::max();
+    edges edges_;
+
+    size_type min_strip_size = size_type(1) << 14; // inputs less than two strips are swept serially
+    size_type strips_per_worker = 2;
+
+private :
+
+    const value_type eps_;
+    thread_pool & pool_;
+
+    site first_;
+    size_type size_ = 0;
+
+    struct grid // sites are grouped into columns of equal sizes, columns are divided into rows of equal heights
+    {
+
+        size_type column_size = 1;
+        size_type columns = 0;
+        size_type rows = 1;
+        value_type ymin = value_type(0);
+        value_type height = value_type(1); // of a row
+
+        std::vector< size_type > offsets; // columns * (rows + 1)
+        std::vector< size_type > cells; // indices of sites ordered by columns and rows
+
+        size_type row(const value_type & y) const
+        {
+            if (!(ymin < y)) {
+                return 0;
+            }
+            using std::floor;
+            const value_type r = floor((y - ymin) / height);
+            if (!(r < value_type(rows))) {
+                return rows - 1;
+            }
+            return size_type(r);
+        }
+
+    } grid_;
+
+    struct seam
+    {
+
+        size_type l, r; // indices of sites, l < r
+        size_type o; // least site of the other end in the strip
+        size_type s; // strip
+        pvertex v; // rank among owned vertices of the strip, then global index
+        edge e; // other end is not known
+        bool b; // v is edge_.b
+        bool ray; // other end is infinite in the strip
+
+        bool operator < (const seam & s) const
+        {
+            return std::tie(l, r) < std::tie(s.l, s.r);
+        }
+
+    };
+
+    struct strip
+    {
+
+        explicit
+        strip(const value_type & eps)
+            : sweepline_{eps}
+        { ; }
+
+        sweepline_type sweepline_;
+
+        size_type l, r; // core
+        size_type lhalo, rhalo;
+        size_type wl, wr; // window
+        bool dirty;
+
+        std::vector< size_type > minimal_sites;
+        std::vector< pvertex > ranks; // of owned vertices, inf for the rest
+        std::vector< pvertex > owned;
+        std::vector< edge > resolved; // ends are ranks
+        std::vector< seam > seams;
+        std::vector< size_type > upper, lower; // convex hull chains of the core
+
+        pvertex vertex_offset;
+        pedge edge_offset;
+
+    };
+
+    std::vector< std::unique_ptr< strip > > strips_;
+    std::vector< seam > seams_;
+    std::vector< std::pair< size_type, size_type > > hull_;
+
+    sweepline_type sweepline_{eps_};
+
+    size_type index(const site s) const
+    {
+        return size_type(s - first_);
+    }
+
+    const point & at(const size_type i) const
+    {
+        return first_[typename std::iterator_traits< site >::difference_type(i)];
+    }
+
+    value_type tolerance() const
+    {
+        return eps_ + eps_;
+    }
+
+    void build_grid()
+    {
+        point pmin = at(0);
+        point pmax = at(size_ - 1);
+        {
+            pmin.y = pmax.y = at(0).y;
+            for (size_type i = 1; i < size_; ++i) {
+                const value_type & y = at(i).y;
+                if (y < pmin.y) {
+                    pmin.y = y;
+                } else if (pmax.y < y) {
+                    pmax.y = y;
+                }
+            }
+        }
+        const value_type width = value_type(pmax.x) - value_type(pmin.x); // integral coordinates can overflow
+        const value_type height = value_type(pmax.y) - value_type(pmin.y);
+        const size_type cells = std::max(size_type(1), size_ / 2); // about two sites per cell
+        using std::sqrt;
+        grid_.ymin = pmin.y;
+        if ((value_type(0) < width) && (value_type(0) < height)) {
+            const value_type side = sqrt(width * height / value_type(cells));
+            grid_.rows = std::max(size_type(1), std::min(cells, size_type(height / side)));
+        } else if (value_type(0) < height) {
+            grid_.rows = cells;
+        } else {
+            grid_.rows = 1;
+        }
+        grid_.height = (value_type(0) < height) ? (height / value_type(grid_.rows)) : value_type(1);
+        grid_.column_size = std::max(size_type(1), (size_ * grid_.rows) / cells);
+        grid_.columns = (size_ + grid_.column_size - 1) / grid_.column_size;
+        grid_.offsets.resize(grid_.columns * (grid_.rows + 1));
+        grid_.cells.resize(size_);
+        pool_.parallel_for(grid_.columns, [&] (const size_type c, size_type)
+        {
+            const size_type l = c * grid_.column_size;
+            const size_type r = std::min(size_, l + grid_.column_size);
+            const auto offsets = std::next(std::begin(grid_.offsets), std::ptrdiff_t(c * (grid_.rows + 1)));
+            std::fill_n(offsets, grid_.rows + 1, size_type(0));
+            for (size_type i = l; i < r; ++i) {
+                ++offsets[std::ptrdiff_t(grid_.row(at(i).y) + 1)];
+            }
+            offsets[0] = l;
+            std::partial_sum(offsets, std::next(offsets, std::ptrdiff_t(grid_.rows + 1)), offsets);
+            for (size_type i = l; i < r; ++i) {
+                grid_.cells[offsets[std::ptrdiff_t(grid_.row(at(i).y))]++] = i;
+            }
+            std::copy_backward(offsets, std::next(offsets, std::ptrdiff_t(grid_.rows)), std::next(offsets, std::ptrdiff_t(grid_.rows + 1)));
+            offsets[0] = l;
+        });
+    }
+
+    // circle of the vertex contains no site out of [wl, wr)
+    bool empty_circle(const vertex & v, const size_type wl, const size_type wr) const
+    {
+        const value_type R = v.R + tolerance();
+        const value_type R2 = R * R;
+        const value_type xmin = v.c.x - R;
+        const value_type xmax = v.c.x + R;
+        const auto outside = [&] (const size_type i) -> bool
+        {
+            if ((wl <= i) && (i < wr)) {
+                return false;
+            }
+            const point & p = at(i);
+            const value_type dx = p.x - v.c.x;
+            const value_type dy = p.y - v.c.y;
+            return (dx * dx + dy * dy < R2);
+        };
+        size_type c = 0;
+        {
+            size_type n = grid_.columns;
+            while (0 < n) { // first column, which last site is not to the left of the circle
+                const size_type h = n / 2;
+                const size_type m = c + h;
+                if (at(std::min(size_, (m + 1) * grid_.column_size) - 1).x < xmin) {
+                    c = m + 1;
+                    n -= h + 1;
+                } else {
+                    n = h;
+                }
+            }
+        }
+        for (; c < grid_.columns; ++c) {
+            const size_type l = c * grid_.column_size;
+            const size_type r = std::min(size_, l + grid_.column_size);
+            const value_type & x0 = at(l).x;
+            const value_type & x1 = at(r - 1).x;
+            if (xmax < x0) {
+                break;
+            }
+            if ((wl <= l) && (r <= wr)) {
+                continue;
+            }
+            value_type dx = value_type(0);
+            if (v.c.x < x0) {
+                dx = x0 - v.c.x;
+            } else if (x1 < v.c.x) {
+                dx = v.c.x - x1;
+            }
+            using std::sqrt;
+            const value_type dy = sqrt(std::max(value_type(0), R2 - dx * dx));
+            const auto offsets = std::next(std::cbegin(grid_.offsets), std::ptrdiff_t(c * (grid_.rows + 1)));
+            const auto b = offsets[std::ptrdiff_t(grid_.row(v.c.y - dy))];
+            const auto e = offsets[std::ptrdiff_t(grid_.row(v.c.y + dy) + 1)];
+            for (auto i = b; i < e; ++i) {
+                if (outside(grid_.cells[i])) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // monotone chain, collinear sites are kept
+    template< typename chain >
+    void convex_chain(chain & _chain, const size_type i, const bool upper) const
+    {
+        const point & p = at(i);
+        while (1 < _chain.size()) {
+            const point & a = at(_chain[_chain.size() - 2]);
+            const point & b = at(_chain.back());
+            const value_type ax = a.x, ay = a.y;
+            const value_type cross = (value_type(b.x) - ax) * (value_type(p.y) - ay) - (value_type(b.y) - ay) * (value_type(p.x) - ax);
+            if (upper ? !(value_type(0) < cross) : !(cross < value_type(0))) {
+                break;
+            }
+            _chain.pop_back();
+        }
+        _chain.push_back(i);
+    }
+
+    void sweep(strip & _strip, const size_type s)
+    {
+        _strip.wl = (_strip.lhalo < _strip.l) ? (_strip.l - _strip.lhalo) : 0;
+        _strip.wr = std::min(size_, _strip.r + _strip.rhalo);
+        sweepline_type & sweepline_ = _strip.sweepline_;
+        sweepline_.clear();
+        sweepline_(std::next(first_, std::ptrdiff_t(_strip.wl)), std::next(first_, std::ptrdiff_t(_strip.wr)));
+        const size_type vsize = sweepline_.vertices_.size();
+        _strip.minimal_sites.assign(vsize, size_);
+        for (const edge & edge_ : sweepline_.edges_) {
+            const size_type m = std::min(index(edge_.l), index(edge_.r));
+            for (const pvertex v : {edge_.b, edge_.e}) {
+                if (v != sweepline_.inf) {
+                    _strip.minimal_sites[v] = std::min(_strip.minimal_sites[v], m);
+                }
+            }
+        }
+        _strip.ranks.assign(vsize, inf);
+        _strip.owned.clear();
+        for (pvertex v = 0; v < vsize; ++v) {
+            const size_type m = _strip.minimal_sites[v];
+            if ((m < _strip.l) || !(m < _strip.r)) {
+                continue;
+            }
+            const vertex & vertex_ = sweepline_.vertices_[v];
+            const value_type R = vertex_.R + tolerance();
+            const bool left = (0 < _strip.wl) && !(at(_strip.wl - 1).x < vertex_.c.x - R);
+            const bool right = (_strip.wr < size_) && !(vertex_.c.x + R < at(_strip.wr).x);
+            if ((left || right) && !empty_circle(vertex_, _strip.wl, _strip.wr)) {
+                continue; // artifact of the boundary of the window
+            }
+            _strip.ranks[v] = pvertex(_strip.owned.size());
+            _strip.owned.push_back(v);
+        }
+        _strip.resolved.clear();
+        _strip.seams.clear();
+        for (const edge & edge_ : sweepline_.edges_) {
+            const bool b = (edge_.b != sweepline_.inf) && (_strip.ranks[edge_.b] != inf);
+            const bool e = (edge_.e != sweepline_.inf) && (_strip.ranks[edge_.e] != inf);
+            if (b && e) {
+                _strip.resolved.push_back({edge_.l, edge_.r, _strip.ranks[edge_.b], _strip.ranks[edge_.e]});
+            } else if (b || e) {
+                const size_type l = index(edge_.l);
+                const size_type r = index(edge_.r);
+                const pvertex v = _strip.ranks[b ? edge_.b : edge_.e];
+                const pvertex o = (b ? edge_.e : edge_.b);
+                const bool ray = (o == sweepline_.inf);
+                _strip.seams.push_back({std::min(l, r), std::max(l, r), (ray ? size_ : _strip.minimal_sites[o]), s,
+                                        v, {edge_.l, edge_.r, (b ? v : inf), (b ? inf : v)}, b, ray});
+            }
+        }
+        _strip.upper.clear();
+        _strip.lower.clear();
+        for (size_type i = _strip.l; i < _strip.r; ++i) {
+            convex_chain(_strip.upper, i, true);
+            convex_chain(_strip.lower, i, false);
+        }
+        _strip.dirty = false;
+    }
+
+    // strip, which core contains the site
+    size_type strip_of(const size_type i) const
+    {
+        const auto s = std::upper_bound(std::cbegin(strips_), std::cend(strips_), i, [] (const size_type j, const auto & strip_) { return j < strip_->l; });
+        return size_type(std::distance(std::cbegin(strips_), s) - 1);
+    }
+
+    // strip should see the site; false if it already sees all the sites
+    bool grow(const size_type s, const size_type i)
+    {
+        strip & strip_ = *strips_[s];
+        if ((0 == strip_.wl) && (strip_.wr == size_)) {
+            return false;
+        }
+        if (!strip_.dirty) {
+            strip_.dirty = true;
+            if (i < strip_.r) {
+                strip_.lhalo += strip_.lhalo;
+            }
+            if (!(i < strip_.l)) {
+                strip_.rhalo += strip_.rhalo;
+            }
+        }
+        return true;
+    }
+
+    enum class result { done, retry, fail };
+
+    result stitch()
+    {
+        seams_.clear();
+        std::vector< size_type > upper, lower;
+        for (const auto & strip_ : strips_) {
+            seams_.insert(std::cend(seams_), std::cbegin(strip_->seams), std::cend(strip_->seams));
+            for (const size_type i : strip_->upper) {
+                convex_chain(upper, i, true);
+            }
+            for (const size_type i : strip_->lower) {
+                convex_chain(lower, i, false);
+            }
+        }
+        hull_.clear();
+        for (const auto & chain_ : {std::cref(upper), std::cref(lower)}) {
+            const auto & c = chain_.get();
+            for (size_type i = 1; i < c.size(); ++i) {
+                hull_.emplace_back(std::min(c[i - 1], c[i]), std::max(c[i - 1], c[i]));
+            }
+        }
+        std::sort(std::begin(hull_), std::end(hull_));
+        std::sort(std::begin(seams_), std::end(seams_));
+        bool retry = false;
+        const auto send = std::cend(seams_);
+        for (auto s = std::cbegin(seams_); s != send;) {
+            auto n = std::next(s);
+            if ((n == send) || (*s < *n)) {
+                if (!s->ray || !std::binary_search(std::cbegin(hull_), std::cend(hull_), std::make_pair(s->l, s->r))) {
+                    // missing vertex is seen by the strip, which owns it, if its window contains all the sites of the vertex
+                    for (const size_type i : {s->l, s->r, s->o}) {
+                        if (i < size_) {
+                            if (!grow(strip_of(i), i)) {
+                                return result::fail;
+                            }
+                        }
+                    }
+                    if (!grow(s->s, s->ray ? strips_[s->s]->l : s->o)) {
+                        return result::fail;
+                    }
+                    retry = true;
+                }
+            } else if ((++n != send) && !(*s < *n)) {
+                return result::fail; // vertex owned twice
+            }
+            s = n;
+        }
+        if (retry) {
+            return result::retry;
+        }
+        pvertex vsize = 0;
+        pedge esize = 0;
+        for (const auto & strip_ : strips_) {
+            strip_->vertex_offset = vsize;
+            strip_->edge_offset = esize;
+            vsize += pvertex(strip_->owned.size());
+            esize += pedge(strip_->resolved.size());
+        }
+        if (vsize == 0) { // all the sites are collinear (at least in the sense of eps)
+            return result::fail;
+        }
+        vertices_.resize(vsize);
+        edges_.resize(esize);
+        pool_.parallel_for(strips_.size(), [&] (const size_type s, size_type)
+        {
+            const strip & strip_ = *strips_[s];
+            const auto & local_vertices_ = strip_.sweepline_.vertices_;
+            pvertex v = strip_.vertex_offset;
+            for (const pvertex o : strip_.owned) {
+                vertices_[v++] = local_vertices_[o];
+            }
+            pedge e = strip_.edge_offset;
+            for (const edge & edge_ : strip_.resolved) {
+                edges_[e++] = {edge_.l, edge_.r, edge_.b + strip_.vertex_offset, edge_.e + strip_.vertex_offset};
+            }
+        });
+        const auto offset = [&] (const seam & seam_) { return seam_.v + strips_[seam_.s]->vertex_offset; };
+        for (auto s = std::cbegin(seams_); s != send; ++s) {
+            edge edge_ = s->e;
+            (s->b ? edge_.b : edge_.e) = offset(*s);
+            const auto n = std::next(s);
+            if ((n != send) && !(*s < *n)) {
+                (s->b ? edge_.e : edge_.b) = offset(*n);
+                if (vertices_[edge_.e].c < vertices_[edge_.b].c) {
+                    std::swap(edge_.l, edge_.r);
+                    std::swap(edge_.b, edge_.e);
+                }
+                s = n;
+            }
+            edges_.push_back(edge_);
+        }
+        if (edges_.size() != vertices_.size() + size_ - 1) { // Euler's formula
+            return result::fail;
+        }
+        return result::done;
+    }
+
+    void serial(const site l, const site r)
+    {
+        vertices_.clear();
+        edges_.clear();
+        sweepline_.clear();
+        sweepline_(l, r);
+        using std::swap;
+        swap(vertices_, sweepline_.vertices_);
+        swap(edges_, sweepline_.edges_);
+    }
+
+public :
+
+    void operator () (const site l, const site r)
+    {
+        assert(std::is_sorted(l, r));
+        assert(vertices_.empty());
+        assert(edges_.empty());
+        first_ = l;
+        size_ = size_type(std::distance(l, r));
+        const size_type count = std::min(pool_.size() * strips_per_worker, size_ / std::max(size_type(1), min_strip_size));
+        if ((pool_.size() < 2) || (count < 2)) {
+            return serial(l, r);
+        }
+        while (strips_.size() < count) {
+            strips_.push_back(std::make_unique< strip >(eps_));
+        }
+        strips_.resize(count);
+        for (size_type s = 0; s < count; ++s) {
+            strip & strip_ = *strips_[s];
+            strip_.l = (size_ * s) / count;
+            strip_.r = (size_ * (s + 1)) / count;
+            strip_.lhalo = strip_.rhalo = std::max(size_type(64), (strip_.r - strip_.l) / 8);
+            strip_.dirty = true;
+        }
+        build_grid();
+        for (;;) {
+            pool_.parallel_for(count, [&] (const size_type s, size_type)
+            {
+                if (strips_[s]->dirty) {
+                    sweep(*strips_[s], s);
+                }
+            });
+            const result result_ = stitch();
+            if (result_ == result::done) {
+                break;
+            }
+            if (result_ == result::fail) {
+                return serial(l, r);
+            }
+        }
+    }
+
+    void clear()
+    {
+        vertices_.clear();
+        edges_.clear();
+    }
+
+};
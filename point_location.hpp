@@ -0,0 +1,197 @@
+#pragma once
+
+#include <type_traits>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <vector>
+
+#include <cassert>
+#include <cstddef>
+#include <cmath>
+
+// Cell of the diagram, which contains a query point (the nearest site), located over the finished diagram instead of a separate search tree.
+// Edges give the Delaunay graph in CSR form; a uniform grid over the bounding box of sites (about sites_per_bucket sites per bucket)
+// keeps the nearest site to the center of every bucket. A query starts from the site of its bucket and walks greedily to neighbours,
+// which are closer to it: a site, which is not the nearest one, always has such a neighbour, so the walk takes O(1) steps on average.
+// Batches of queries are located in blocks: bucket indices of a block are computed first by a branch-free loop, then the walks are done.
+// Queries are const, so any number of threads can locate concurrently; build() keeps capacity of the buffers.
+template< typename site,
+          typename value_type = decltype(std::declval< typename std::iterator_traits< site >::value_type >().x) >
+struct point_location
+{
+
+    using size_type = std::size_t;
+    using psite = size_type; // index of a site from the first one
+    using promoted_type = decltype(std::declval< value_type >() * 0.0);
+
+    static constexpr size_type block_size = 64; // queries per block of a batch
+
+    double sites_per_bucket = 2.0;
+
+    // edges_ of a kept diagram (keep_diagram or compact_diagram) of n sites from first
+    template< typename edges >
+    void build(const site first, const size_type n, const edges & edges_)
+    {
+        assert(0 < n);
+        first_ = first;
+        make_graph(n, edges_);
+        make_grid(n);
+    }
+
+    template< typename P >
+    psite locate(const P & p) const
+    {
+        return nearest(p, seeds_[bucket(p)]);
+    }
+
+    // *out++ = locate(*first++) for all queries
+    template< typename iterator, typename output >
+    output locate(iterator first, const iterator last, output out) const
+    {
+        size_type buckets[block_size];
+        while (first != last) {
+            iterator l = first;
+            size_type size = 0;
+            for (; (size < block_size) && (first != last); ++first) {
+                buckets[size++] = bucket(*first);
+            }
+            for (size_type i = 0; i < size; ++i, ++l) {
+                *out = nearest(*l, seeds_[buckets[i]]);
+                ++out;
+            }
+        }
+        return out;
+    }
+
+private :
+
+    site first_;
+
+    std::vector< size_type > offsets_; // neighbours of site i are [offsets_[i], offsets_[i + 1]) of neighbours_
+    std::vector< psite > neighbours_;
+
+    promoted_type x0_, y0_; // of the grid
+    promoted_type sx_, sy_; // buckets per unit
+    size_type columns_, rows_;
+    std::vector< psite > seeds_; // nearest sites to centers of buckets, row by row
+
+    template< typename handle >
+    psite index(const handle & h) const
+    {
+        if constexpr (std::is_integral< handle >::value) {
+            return psite(h);
+        } else {
+            return psite(std::distance(first_, h));
+        }
+    }
+
+    template< typename edges >
+    void make_graph(const size_type n, const edges & edges_)
+    {
+        offsets_.assign(n + 1, 0);
+        for (const auto & edge_ : edges_) {
+            ++offsets_[index(edge_.l) + 1];
+            ++offsets_[index(edge_.r) + 1];
+        }
+        std::partial_sum(std::cbegin(offsets_), std::cend(offsets_), std::begin(offsets_));
+        neighbours_.resize(offsets_.back());
+        for (const auto & edge_ : edges_) { // offsets_[i] is moved to the end of the neighbours of i - 1
+            const psite l = index(edge_.l);
+            const psite r = index(edge_.r);
+            neighbours_[offsets_[l]++] = r;
+            neighbours_[offsets_[r]++] = l;
+        }
+        std::copy_backward(std::cbegin(offsets_), std::prev(std::cend(offsets_)), std::end(offsets_));
+        offsets_.front() = 0;
+    }
+
+    const auto & get(const psite i) const
+    {
+        return first_[typename std::iterator_traits< site >::difference_type(i)];
+    }
+
+    void make_grid(const size_type n)
+    {
+        promoted_type xmin = get(0).x, xmax = xmin;
+        promoted_type ymin = get(0).y, ymax = ymin;
+        for (psite i = 1; i < n; ++i) {
+            const auto & s = get(i);
+            xmin = std::min(xmin, promoted_type(s.x));
+            xmax = std::max(xmax, promoted_type(s.x));
+            ymin = std::min(ymin, promoted_type(s.y));
+            ymax = std::max(ymax, promoted_type(s.y));
+        }
+        const promoted_type w = xmax - xmin, h = ymax - ymin;
+        const size_type buckets = std::max(size_type(1), size_type(double(n) / sites_per_bucket));
+        if (!(promoted_type(0) < h)) {
+            columns_ = (promoted_type(0) < w) ? buckets : 1;
+        } else if (!(promoted_type(0) < w)) {
+            columns_ = 1;
+        } else {
+            using std::sqrt;
+            columns_ = std::min(buckets, std::max(size_type(1), size_type(sqrt(promoted_type(buckets) * w / h))));
+        }
+        rows_ = std::max(size_type(1), buckets / columns_);
+        x0_ = xmin;
+        y0_ = ymin;
+        sx_ = (promoted_type(0) < w) ? (promoted_type(columns_) / w) : promoted_type(0);
+        sy_ = (promoted_type(0) < h) ? (promoted_type(rows_) / h) : promoted_type(0);
+        seeds_.resize(columns_ * rows_);
+        struct center { promoted_type x, y; };
+        psite s = 0;
+        for (size_type r = 0; r < rows_; ++r) {
+            const psite row = s; // the walk to the next row starts from the first bucket of this one
+            for (size_type c = 0; c < columns_; ++c) {
+                const center p{xmin + (promoted_type(c) + promoted_type(0.5)) * w / promoted_type(columns_),
+                               ymin + (promoted_type(r) + promoted_type(0.5)) * h / promoted_type(rows_)};
+                s = nearest(p, s);
+                seeds_[r * columns_ + c] = s;
+            }
+            s = nearest(center{xmin, ymin + (promoted_type(r) + promoted_type(1.5)) * h / promoted_type(rows_)}, row);
+        }
+    }
+
+    static size_type cell(const promoted_type t, const size_type size)
+    {
+        return size_type(std::min(std::max(t, promoted_type(0)), promoted_type(size - 1)));
+    }
+
+    template< typename P >
+    size_type bucket(const P & p) const
+    {
+        return cell((promoted_type(p.y) - y0_) * sy_, rows_) * columns_ + cell((promoted_type(p.x) - x0_) * sx_, columns_);
+    }
+
+    template< typename P >
+    promoted_type sqr_distance(const psite i, const P & p) const
+    {
+        const auto & s = get(i);
+        const promoted_type dx = promoted_type(s.x) - promoted_type(p.x);
+        const promoted_type dy = promoted_type(s.y) - promoted_type(p.y);
+        return dx * dx + dy * dy;
+    }
+
+    template< typename P >
+    psite nearest(const P & p, psite i) const
+    {
+        promoted_type d = sqr_distance(i, p);
+        for (bool moved = true; moved;) {
+            moved = false;
+            const psite j = i;
+            for (size_type k = offsets_[j]; k < offsets_[j + 1]; ++k) {
+                const psite n = neighbours_[k];
+                const promoted_type dn = sqr_distance(n, p);
+                if (dn < d) {
+                    d = dn;
+                    i = n;
+                    moved = true;
+                }
+            }
+        }
+        return i;
+    }
+
+};
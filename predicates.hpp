@@ -0,0 +1,221 @@
+#pragma once
+
+#include <algorithm>
+#include <numeric>
+#include <limits>
+
+#include <cassert>
+#include <cstddef>
+#include <cmath>
+
+// signs of polynomials of coordinates with respect to a threshold, which are exact, but as fast as plain evaluation in the common case:
+// the polynomial is evaluated in floating point first and only if it is closer to the threshold than a forward error bound,
+// then it is evaluated exactly in expansion arithmetic (Shewchuk): a value is a sum of non-overlapping floating point components
+// round to nearest is assumed without extended precision of intermediates (SSE2 is fine), underflow and overflow are not handled
+namespace predicates
+{
+
+// x + y == a + b exactly (a and b are copies: x can be the same variable as a, e.g. in sum)
+template< typename value_type >
+void two_sum(const value_type a, const value_type b, value_type & x, value_type & y)
+{
+    x = a + b;
+    const value_type bv = x - a;
+    const value_type av = x - bv;
+    y = (a - av) + (b - bv);
+}
+
+// x + y == a * b exactly
+template< typename value_type >
+void two_product(const value_type & a, const value_type & b, value_type & x, value_type & y)
+{
+    x = a * b;
+    using std::fma;
+    y = fma(a, b, -x);
+}
+
+// components are increasing by magnitude and non-overlapping, zero ones are eliminated, so the sign is the sign of the last one
+template< typename value_type, std::size_t capacity >
+struct expansion
+{
+
+    value_type c[capacity];
+    std::size_t size = 0;
+
+    void push_back(const value_type & x)
+    {
+        if (x != value_type(0)) {
+            c[size++] = x;
+        }
+    }
+
+    int sign() const
+    {
+        if (size == 0) {
+            return 0;
+        }
+        return (value_type(0) < c[size - 1]) ? +1 : ((c[size - 1] < value_type(0)) ? -1 : 0);
+    }
+
+};
+
+template< typename value_type >
+expansion< value_type, 2 > difference(const value_type & a, const value_type & b)
+{
+    value_type x, y;
+    two_sum(a, -b, x, y);
+    expansion< value_type, 2 > d;
+    d.push_back(y);
+    d.push_back(x);
+    return d;
+}
+
+template< typename value_type, std::size_t l >
+expansion< value_type, l > negation(expansion< value_type, l > e)
+{
+    for (std::size_t i = 0; i < e.size; ++i) {
+        e.c[i] = -e.c[i];
+    }
+    return e;
+}
+
+// Fast-Expansion-Sum: components of both are merged by magnitude, then summed up from the least one
+template< typename value_type, std::size_t l, std::size_t r >
+expansion< value_type, l + r > sum(const expansion< value_type, l > & e, const expansion< value_type, r > & f)
+{
+    expansion< value_type, l + r > h;
+    std::size_t i = 0, j = 0, n = 0;
+    using std::abs;
+    while ((i < e.size) && (j < f.size)) {
+        h.c[n++] = (abs(e.c[i]) < abs(f.c[j])) ? e.c[i++] : f.c[j++];
+    }
+    while (i < e.size) {
+        h.c[n++] = e.c[i++];
+    }
+    while (j < f.size) {
+        h.c[n++] = f.c[j++];
+    }
+    if (n == 0) {
+        return h;
+    }
+    value_type Q = h.c[0];
+    for (std::size_t k = 1; k < n; ++k) { // h.c[k] is read before h.size reaches k
+        value_type x;
+        two_sum(Q, h.c[k], Q, x);
+        h.push_back(x);
+    }
+    h.push_back(Q);
+    return h;
+}
+
+// Scale-Expansion
+template< typename value_type, std::size_t l >
+expansion< value_type, 2 * l > scale(const expansion< value_type, l > & e, const value_type & b)
+{
+    expansion< value_type, 2 * l > h;
+    if (e.size == 0) {
+        return h;
+    }
+    value_type Q, x;
+    two_product(e.c[0], b, Q, x);
+    h.push_back(x);
+    for (std::size_t i = 1; i < e.size; ++i) {
+        value_type p1, p0, s;
+        two_product(e.c[i], b, p1, p0);
+        two_sum(Q, p0, s, x);
+        h.push_back(x);
+        two_sum(p1, s, Q, x);
+        h.push_back(x);
+    }
+    h.push_back(Q);
+    return h;
+}
+
+template< typename value_type, std::size_t l, std::size_t r >
+expansion< value_type, 2 * l * r > product(const expansion< value_type, l > & e, const expansion< value_type, r > & f)
+{
+    expansion< value_type, 2 * l * r > p;
+    for (std::size_t j = 0; j < f.size; ++j) {
+        const auto q = sum(p, scale(e, f.c[j]));
+        assert(!(2 * l * r < q.size));
+        p.size = q.size;
+        std::copy_n(q.c, q.size, p.c);
+    }
+    return p;
+}
+
+template< typename value_type >
+constexpr value_type epsilon = std::numeric_limits< value_type >::epsilon() / 2; // unit roundoff
+
+// sign of (a - c) x (b - c) - t = (ay - cy) * (bx - cx) - (ax - cx) * (by - cy) - t, where (0 < .) is CW
+template< typename value_type >
+int orientation(const value_type & ax, const value_type & ay,
+                const value_type & bx, const value_type & by,
+                const value_type & cx, const value_type & cy,
+                const value_type & t)
+{
+    using std::abs;
+    const value_type l = (ay - cy) * (bx - cx);
+    const value_type r = (ax - cx) * (by - cy);
+    const value_type d = l - r - t;
+    const value_type bound = value_type(8) * epsilon< value_type > * (abs(l) + abs(r) + abs(t));
+    if (bound < d) {
+        return +1;
+    } else if (d < -bound) {
+        return -1;
+    }
+    const auto L = product(difference(ay, cy), difference(bx, cx));
+    const auto R = product(difference(ax, cx), difference(by, cy));
+    return sum(sum(L, negation(R)), difference(value_type(0), t)).sign();
+}
+
+// (a - c) x (b - c) of orientation: components of the exact expansion are summed up from the least one,
+// so the sign is always right (unlike in plain evaluation, which can round a small value to zero or to the opposite sign)
+template< typename value_type >
+value_type determinant(const value_type & ax, const value_type & ay,
+                       const value_type & bx, const value_type & by,
+                       const value_type & cx, const value_type & cy)
+{
+    const auto L = product(difference(ay, cy), difference(bx, cx));
+    const auto R = product(difference(ax, cx), difference(by, cy));
+    const auto D = sum(L, negation(R));
+    return std::accumulate(D.c, D.c + D.size, value_type(0));
+}
+
+// breakpoint of sites l and r (lx != rx) at the sweep line x == px compared with the point (X, py) on the bisector of l and r:
+// sign of |(X, py) - r|^2 - (px - X)^2 - t, that is the sign of
+// G - t * D, multiplied by the sign of D, where D = lx - rx, u = rx - px, v = ry - py, w = ly - ry,
+// G = D * (v^2 - u^2) - u * D^2 - u * w * (2 * v + w) (without division)
+template< typename value_type >
+int breakpoint(const value_type & lx, const value_type & ly,
+               const value_type & rx, const value_type & ry,
+               const value_type & px, const value_type & py,
+               const value_type & t)
+{
+    using std::abs;
+    const value_type D = lx - rx;
+    const value_type u = rx - px;
+    const value_type v = ry - py;
+    const value_type w = ly - ry;
+    const value_type s = v + v + w;
+    const value_type G = D * (v * v - u * u) - u * D * D - u * w * s;
+    const value_type g = (value_type(0) < D) ? (G - t * D) : (t * D - G);
+    const value_type P = abs(D) * (v * v + u * u) + abs(u) * D * D + abs(u * w) * (abs(v + v) + abs(w)) + abs(t * D);
+    const value_type bound = value_type(16) * epsilon< value_type > * P;
+    if (bound < g) {
+        return +1;
+    } else if (g < -bound) {
+        return -1;
+    }
+    const auto DE = difference(lx, rx);
+    const auto uE = difference(rx, px);
+    const auto vE = difference(ry, py);
+    const auto wE = difference(ly, ry);
+    const auto A = sum(product(vE, vE), negation(product(uE, uE))); // v^2 - u^2
+    const auto S = sum(sum(vE, vE), wE); // 2 * v + w
+    const auto F = sum(sum(product(DE, A), negation(product(uE, product(DE, DE)))),
+                       sum(negation(product(product(uE, wE), S)), scale(DE, -t)));
+    return (value_type(0) < D) ? F.sign() : -F.sign();
+}
+
+}
@@ -4,6 +4,7 @@
 #include <utility>
 #include <iterator>
 #include <memory>
+#include <algorithm>
 
 #include <cassert>
 
@@ -410,9 +411,11 @@ struct tree_iterator
 
 };
 
+// arena: nodes are carved from contiguous blocks, which grow geometrically and are released all at once by clear()
 template< typename type,
           typename compare = std::less< type >,
-          typename allocator = std::allocator< type > >
+          typename allocator = std::allocator< type >,
+          bool arena = false >
 struct tree
 {
 
@@ -435,18 +438,66 @@ private :
 
     node_pointer pool = nullptr;
 
-    node_pointer
-    get_node()
+    // first node of each block is a header: p points to the next block, l points past the end of the block
+    node_pointer blocks = nullptr;
+    size_type capacity = 0;
+
+    static constexpr size_type min_block_size = 64;
+
+    void put_node(const node_pointer n) noexcept
     {
-        if (pool) {
-            return std::exchange(pool, node_pointer(pool->r));
+        n->r = std::exchange(pool, n);
+    }
+
+    void add_block(const size_type n)
+    {
+        const node_pointer b = ::new (allocator_traits::allocate(a, n + 1)) node_type;
+        b->p = std::exchange(blocks, b);
+        b->l = b + n + 1;
+        for (size_type i = n; 0 < i; --i) { // nodes are taken from the pool in the order of addresses
+            put_node(::new (b + i) node_type);
         }
-        return ::new (allocator_traits::allocate(a, 1)) node_type;
+        capacity += n;
     }
 
-    void put_node(const node_pointer n) noexcept
+    void drop_blocks() noexcept
     {
-        n->r = std::exchange(pool, n);
+        while (blocks) {
+            const node_pointer b = blocks;
+            blocks = node_pointer(b->p);
+            const auto n = size_type(node_pointer(b->l) - b);
+            for (size_type i = 0; i < n; ++i) {
+                b[i].~node_type();
+            }
+            allocator_traits::deallocate(a, b, n);
+        }
+        pool = nullptr;
+        capacity = 0;
+    }
+
+    // all the nodes of the blocks are free
+    void refill_pool() noexcept
+    {
+        pool = nullptr;
+        for (node_pointer b = blocks; b; b = node_pointer(b->p)) {
+            const auto n = size_type(node_pointer(b->l) - b);
+            for (size_type i = n - 1; 0 < i; --i) {
+                put_node(b + i);
+            }
+        }
+    }
+
+    node_pointer
+    get_node()
+    {
+        if (!pool) {
+            if constexpr (arena) {
+                add_block(std::max(capacity, min_block_size));
+            } else {
+                return ::new (allocator_traits::allocate(a, 1)) node_type;
+            }
+        }
+        return std::exchange(pool, node_pointer(pool->r));
     }
 
     template< typename ...types >
@@ -508,30 +559,63 @@ public :
 
     void reserve(size_type n)
     {
-        node_pointer p = pool;
-        while (p && (s < n)) {
-            p = p->r;
-            --n;
-        }
-        while (s < n) {
-            put_node(get_node());
-            --n;
+        if constexpr (arena) {
+            if (capacity < n) {
+                add_block(n - capacity);
+            }
+        } else {
+            base_pointer p = pool;
+            while (p && (s < n)) {
+                p = p->r;
+                --n;
+            }
+            while (s < n) {
+                put_node(::new (allocator_traits::allocate(a, 1)) node_type);
+                --n;
+            }
         }
     }
 
+    // memory taken by reserve(n) of an empty tree
+    static constexpr size_type reserved_bytes(const size_type n) noexcept
+    {
+        return (arena ? (n + 1) : n) * sizeof(node_type);
+    }
+
+    // in arena mode nodes can be released only all at once
     void shrink_to_fit() noexcept
     {
-        while (pool) {
-            const base_pointer p = pool->r;
-            pool->~node_type();
-            allocator_traits::deallocate(a, std::exchange(pool, node_pointer(p)), 1);
+        if constexpr (arena) {
+            if (empty()) {
+                drop_blocks();
+            }
+        } else {
+            while (pool) {
+                const base_pointer p = pool->r;
+                pool->~node_type();
+                allocator_traits::deallocate(a, std::exchange(pool, node_pointer(p)), 1);
+            }
         }
     }
 
     void clear() noexcept
     {
-        erase(h.p);
+        if constexpr (!arena || !std::is_trivially_destructible< value_type >::value) {
+            erase(h.p);
+        }
+        h = {&h};
+        s = 0;
         shrink_to_fit();
+    }
+
+    // as clear(), but all the nodes are kept for reuse, so refilling the tree up to the former size does not allocate
+    void reset() noexcept
+    {
+        if constexpr (arena && std::is_trivially_destructible< value_type >::value) {
+            refill_pool();
+        } else {
+            erase(h.p);
+        }
         h = {&h};
         s = 0;
     }
@@ -562,6 +646,19 @@ public :
         return {base_pointer(r.p)};
     }
 
+    // erases every element, for which f(element) is true (f is called once for each of them in order)
+    template< typename F >
+    void erase_if(F && f)
+    {
+        for (const_iterator x = cbegin(); x != cend();) {
+            if (f(*x)) {
+                x = erase(x);
+            } else {
+                ++x;
+            }
+        }
+    }
+
 private :
 
     static const value_type & value(const base_pointer n) { return *node_pointer(n)->pointer(); }
@@ -722,6 +819,44 @@ public :
         return {r};
     }
 
+    // finger search: climbs from the hint only until the subtree, which contains the result, then descends,
+    // it takes O(log d) comparisons, where d is the distance between the hint and the result, but up to twice as many as lower_bound() for far ones
+    template< typename K = value_type, typename ...P >
+    iterator
+    lower_bound_from(const const_iterator hint, const K & k, P &... p)
+    {
+        base_pointer x = hint.p;
+        if (x == &h) {
+            return lower_bound(k, p...);
+        }
+        const bool right = c(value(x), k, p...);
+        base_pointer r = right ? base_pointer(&h) : x;
+        while (x != h.p) {
+            const base_pointer y = x->p;
+            if (right == (x == y->l)) { // y is on the side of the result
+                if (right != c(value(y), k, p...)) { // the result is in the subtree of x (or it is y, if right)
+                    if (right) {
+                        r = y;
+                    }
+                    break;
+                }
+                if (!right) {
+                    r = y;
+                }
+            }
+            x = y;
+        }
+        while (x) {
+            if (c(value(x), k, p...)) {
+                x = x->r;
+            } else {
+                r = x;
+                x = x->l;
+            }
+        }
+        return {r};
+    }
+
     template< typename K = value_type, typename ...P >
     iterator
     upper_bound(const K & k, P &... p)
@@ -751,6 +886,18 @@ public :
         return {l, r};
     }
 
+    template< typename K = value_type, typename ...P >
+    range< iterator >
+    equal_range_from(const const_iterator hint, const K & k, P &... p)
+    {
+        auto l = lower_bound_from(hint, k, p...);
+        auto r = l;
+        while ((r != end()) && !c(k, value(r), p...)) {
+            ++r;
+        }
+        return {l, r};
+    }
+
     template< typename K = value_type, typename ...P >
     iterator
     find(const K & k, P &... p)
@@ -775,4 +922,10 @@ template< typename key_type,
           typename allocator_type = std::allocator< pair< key_type const, mapped_type > > >
 using map = tree< typename allocator_type::value_type, adapt_compare< typename allocator_type::value_type, compare >, allocator_type >;
 
+template< typename key_type,
+          typename mapped_type,
+          typename compare = std::less< key_type >,
+          typename allocator_type = std::allocator< pair< key_type const, mapped_type > > >
+using arena_map = tree< typename allocator_type::value_type, adapt_compare< typename allocator_type::value_type, compare >, allocator_type, true >;
+
 }
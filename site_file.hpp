@@ -0,0 +1,331 @@
+#pragma once
+
+#include "thread_pool.hpp"
+
+#include <type_traits>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <numeric>
+#include <vector>
+#include <limits>
+#include <fstream>
+#include <charconv>
+#include <system_error>
+#include <stdexcept>
+
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// input of sites
+// binary file: header, then sites as packed (x, y) pairs of the coordinate type in native byte order,
+// it is mapped into memory, so sites can be swept in place (if they are sorted) without any copying
+// text: number of sites, then one site "x y" per line, it is parsed by std::from_chars in chunks of lines
+namespace site_file
+{
+
+enum class dtype : std::uint32_t
+{
+    float32 = 1,
+    float64 = 2,
+    int32 = 3,
+};
+
+template< typename value_type >
+constexpr dtype dtype_of()
+{
+    if constexpr (std::is_same< value_type, float >::value) {
+        return dtype::float32;
+    } else if constexpr (std::is_same< value_type, double >::value) {
+        return dtype::float64;
+    } else {
+        static_assert(std::is_same< value_type, std::int32_t >::value, "float, double or int32_t coordinates expected");
+        return dtype::int32;
+    }
+}
+
+struct header
+{
+
+    static constexpr char signature[8] = {'s', 'w', 'e', 'e', 'p', 's', 'i', 't'};
+    static constexpr std::uint32_t current_version = 1;
+
+    enum : std::uint32_t
+    {
+        sorted = 1, // sites are in (x, y) order
+    };
+
+    char magic[8];
+    std::uint32_t version; // also detects foreign byte order
+    dtype type;
+    std::uint64_t size; // number of sites
+    std::uint32_t flags;
+    std::uint32_t reserved;
+    double bbox[4]; // xmin, ymin, xmax, ymax
+
+};
+
+static_assert(sizeof(header) == 64, "sites are aligned by the header");
+
+template< typename point >
+using coordinate_type = std::remove_cv_t< decltype(std::declval< point >().x) >;
+
+// point is mapped onto a pair of coordinates
+template< typename point >
+constexpr bool is_packed = std::is_trivially_copyable< point >::value && (sizeof(point) == 2 * sizeof(coordinate_type< point >));
+
+// read only mapping of a whole file
+class mapped_file
+{
+
+    void * data_ = MAP_FAILED;
+    std::size_t size_ = 0;
+
+public :
+
+    explicit
+    mapped_file(const char * const path)
+    {
+        const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::system_error{errno, std::generic_category(), path};
+        }
+        struct ::stat stat_;
+        if (::fstat(fd, &stat_) != 0) {
+            const int error = errno;
+            ::close(fd);
+            throw std::system_error{error, std::generic_category(), path};
+        }
+        size_ = std::size_t(stat_.st_size);
+        if (0 < size_) {
+            data_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        const int error = errno;
+        ::close(fd);
+        if ((0 < size_) && (data_ == MAP_FAILED)) {
+            throw std::system_error{error, std::generic_category(), path};
+        }
+        if (0 < size_) {
+            ::madvise(data_, size_, MADV_SEQUENTIAL);
+        }
+    }
+
+    mapped_file(const mapped_file &) = delete;
+    mapped_file(mapped_file &&) = delete;
+    void operator = (const mapped_file &) = delete;
+    void operator = (mapped_file &&) = delete;
+
+    ~mapped_file()
+    {
+        if (data_ != MAP_FAILED) {
+            ::munmap(data_, size_);
+        }
+    }
+
+    const char * data() const { return (data_ == MAP_FAILED) ? nullptr : static_cast< const char * >(data_); }
+    std::size_t size() const { return size_; }
+
+    const char * begin() const { return data(); }
+    const char * end() const { return data() + size_; }
+
+};
+
+// header of a binary file, throws if the file is not of the format
+inline
+const header & get_header(const mapped_file & _file)
+{
+    if (_file.size() < sizeof(header)) {
+        throw std::runtime_error{"site file: no header"};
+    }
+    const auto & header_ = *reinterpret_cast< const header * >(_file.data());
+    if (std::memcmp(header_.magic, header::signature, sizeof header::signature) != 0) {
+        throw std::runtime_error{"site file: bad signature"};
+    }
+    if (header_.version != header::current_version) {
+        throw std::runtime_error{"site file: unsupported version or byte order"};
+    }
+    return header_;
+}
+
+template< typename point >
+struct sites
+{
+
+    const point * first;
+    const point * last;
+
+    const point * begin() const { return first; }
+    const point * end() const { return last; }
+
+    std::size_t size() const { return std::size_t(last - first); }
+
+};
+
+// sites of the binary file in place, their coordinates should be of point's type
+template< typename point >
+sites< point > get_sites(const mapped_file & _file)
+{
+    static_assert(is_packed< point >, "point should consist of x and y only");
+    using value_type = coordinate_type< point >;
+    const header & header_ = get_header(_file);
+    if (header_.type != dtype_of< value_type >()) {
+        throw std::runtime_error{"site file: unexpected coordinate type"};
+    }
+    if ((_file.size() - sizeof(header)) / sizeof(point) < header_.size) {
+        throw std::runtime_error{"site file: truncated"};
+    }
+    const auto first = reinterpret_cast< const point * >(_file.data() + sizeof(header));
+    assert((reinterpret_cast< std::uintptr_t >(first) % alignof(point)) == 0); // mapping is page aligned
+    return {first, first + header_.size};
+}
+
+template< typename iterator >
+void write(const char * const path, const iterator first, const iterator last)
+{
+    using point = typename std::iterator_traits< iterator >::value_type;
+    using value_type = coordinate_type< point >;
+    header header_ = {};
+    std::copy(std::cbegin(header::signature), std::cend(header::signature), header_.magic);
+    header_.version = header::current_version;
+    header_.type = dtype_of< value_type >();
+    header_.size = std::uint64_t(std::distance(first, last));
+    header_.flags = std::is_sorted(first, last) ? std::uint32_t(header::sorted) : std::uint32_t(0);
+    header_.bbox[0] = header_.bbox[1] = +std::numeric_limits< double >::infinity();
+    header_.bbox[2] = header_.bbox[3] = -std::numeric_limits< double >::infinity();
+    for (auto p = first; p != last; ++p) {
+        header_.bbox[0] = std::min(header_.bbox[0], double(p->x));
+        header_.bbox[1] = std::min(header_.bbox[1], double(p->y));
+        header_.bbox[2] = std::max(header_.bbox[2], double(p->x));
+        header_.bbox[3] = std::max(header_.bbox[3], double(p->y));
+    }
+    std::ofstream out_{path, std::ios::binary | std::ios::trunc};
+    out_.write(reinterpret_cast< const char * >(&header_), sizeof header_);
+    constexpr std::size_t buffer_size = 4096;
+    value_type buffer[buffer_size];
+    std::size_t n = 0;
+    for (auto p = first; p != last; ++p) {
+        buffer[n++] = p->x;
+        buffer[n++] = p->y;
+        if (n == buffer_size) {
+            out_.write(reinterpret_cast< const char * >(buffer), std::streamsize(sizeof buffer));
+            n = 0;
+        }
+    }
+    out_.write(reinterpret_cast< const char * >(buffer), std::streamsize(n * sizeof(value_type)));
+    if (!out_.flush()) {
+        throw std::runtime_error{"site file: write failed"};
+    }
+}
+
+inline
+const char * skip_spaces(const char * first, const char * const last)
+{
+    while ((first != last) && ((*first == ' ') || (*first == '\t') || (*first == '\n') || (*first == '\r'))) {
+        ++first;
+    }
+    return first;
+}
+
+template< typename value_type >
+const char * parse_value(const char * first, const char * const last, value_type & value)
+{
+    first = skip_spaces(first, last);
+    if ((first != last) && (*first == '+')) { // from_chars does not accept it
+        ++first;
+    }
+    const auto result = std::from_chars(first, last, value);
+    return (result.ec == std::errc{}) ? result.ptr : nullptr;
+}
+
+// appends sites of [first, last) to points, returns false if there is anything else
+template< typename point >
+bool parse_sites(const char * first, const char * const last, std::vector< point > & points)
+{
+    for (;;) {
+        if ((first = skip_spaces(first, last)) == last) {
+            return true;
+        }
+        point point_;
+        if (!(first = parse_value(first, last, point_.x))) {
+            return false;
+        }
+        if (!(first = parse_value(first, last, point_.y))) {
+            return false;
+        }
+        points.push_back(std::move(point_));
+    }
+}
+
+// number of sites, then the sites; returns a pointer past the number or nullptr
+inline
+const char * parse_size(const char * const first, const char * const last, std::size_t & size)
+{
+    return parse_value(first, last, size);
+}
+
+template< typename point >
+bool parse(const char * first, const char * const last, std::vector< point > & points)
+{
+    std::size_t size = 0;
+    if (!(first = parse_size(first, last, size))) {
+        return false;
+    }
+    const std::size_t offset = points.size();
+    points.reserve(offset + size);
+    return parse_sites(first, last, points) && (points.size() == offset + size);
+}
+
+// chunks are split at line ends and parsed in parallel, then gathered in order
+template< typename point >
+bool parse(const char * first, const char * const last, std::vector< point > & points, thread_pool & pool)
+{
+    constexpr std::size_t min_chunk_size = std::size_t(1) << 20; // bytes
+    const std::size_t chunks = std::min(4 * pool.size(), std::size_t(last - first) / min_chunk_size);
+    if (chunks < 2) {
+        return parse(first, last, points);
+    }
+    std::size_t size = 0;
+    if (!(first = parse_size(first, last, size))) {
+        return false;
+    }
+    std::vector< const char * > bounds(chunks + 1, last);
+    bounds[0] = first;
+    for (std::size_t c = 1; c < chunks; ++c) {
+        const char * const bound = first + (std::size_t(last - first) * c) / chunks;
+        const char * const eol = std::find(std::max(bound, bounds[c - 1]), last, '\n');
+        bounds[c] = (eol == last) ? last : std::next(eol);
+    }
+    std::vector< std::vector< point > > parts(chunks);
+    std::vector< char > valid(chunks); // not std::vector< bool >: flags are set concurrently
+    pool.parallel_for(chunks, [&] (const std::size_t c, std::size_t)
+    {
+        parts[c].reserve(size / chunks + 1);
+        valid[c] = char(parse_sites(bounds[c], bounds[c + 1], parts[c]));
+    });
+    if (std::find(std::cbegin(valid), std::cend(valid), char(false)) != std::cend(valid)) {
+        return false;
+    }
+    std::vector< std::size_t > offsets(chunks + 1, points.size());
+    for (std::size_t c = 0; c < chunks; ++c) {
+        offsets[c + 1] = offsets[c] + parts[c].size();
+    }
+    if (offsets.back() != points.size() + size) {
+        return false;
+    }
+    points.resize(offsets.back());
+    pool.parallel_for(chunks, [&] (const std::size_t c, std::size_t)
+    {
+        std::move(std::begin(parts[c]), std::end(parts[c]), std::next(std::begin(points), std::ptrdiff_t(offsets[c])));
+    });
+    return true;
+}
+
+}
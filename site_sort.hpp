@@ -0,0 +1,294 @@
+#pragma once
+
+#include "thread_pool.hpp"
+
+#include <type_traits>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <numeric>
+#include <memory>
+#include <vector>
+#include <limits>
+
+#include <cassert>
+#include <cstring>
+#include <cstdint>
+
+namespace site_sort
+{
+
+// unsigned integer, which preserves order of the value: (l < r) == (key(l) < key(r))
+// -0.0 and +0.0 have the same key, NaNs are not supported
+template< typename value_type >
+auto key(value_type v) noexcept
+{
+    static_assert(std::is_arithmetic< value_type >::value, "coordinates should be of arithmetic type");
+    if constexpr (std::is_floating_point< value_type >::value) {
+        static_assert(std::numeric_limits< value_type >::is_iec559, "IEEE 754 floating point expected");
+        using bits = std::conditional_t< (sizeof(value_type) == sizeof(std::uint32_t)), std::uint32_t, std::uint64_t >;
+        static_assert(sizeof(value_type) == sizeof(bits), "float or double expected");
+        v += value_type(0); // -0.0 + 0.0 == +0.0
+        bits b;
+        std::memcpy(&b, &v, sizeof b);
+        constexpr bits sign = bits(1) << (std::numeric_limits< bits >::digits - 1);
+        return bits((b & sign) ? ~b : (b | sign));
+    } else {
+        using bits = std::make_unsigned_t< value_type >;
+        if constexpr (std::is_signed< value_type >::value) {
+            constexpr bits sign = bits(1) << (std::numeric_limits< bits >::digits - 1);
+            return bits(bits(v) ^ sign);
+        } else {
+            return bits(v);
+        }
+    }
+}
+
+template< typename point >
+using key_type = decltype(key(std::declval< point >().x));
+
+template< typename point, typename index >
+struct record
+{
+
+    key_type< point > x;
+    index i;
+
+    bool operator < (const record & r) const noexcept
+    {
+        return (x < r.x);
+    }
+
+};
+
+// LSD radix sort of [first, last) by x, tmp should have the same size
+// digits, which are the same for all records, are skipped; histograms is a buffer, which can be reused between sorts
+template< typename point, typename index >
+void radix(record< point, index > * first, record< point, index > * last, record< point, index > * tmp, std::vector< index > & histograms)
+{
+    using record_type = record< point, index >;
+    using bits = key_type< point >;
+    constexpr std::size_t radix_bits = 11;
+    constexpr std::size_t buckets = std::size_t(1) << radix_bits;
+    constexpr bits mask = bits(buckets - 1);
+    constexpr std::size_t digits = (std::numeric_limits< bits >::digits + radix_bits - 1) / radix_bits;
+    const auto size = std::size_t(last - first);
+    if (size < 2) {
+        return;
+    }
+    histograms.assign(digits * buckets, index(0));
+    for (const record_type * r = first; r != last; ++r) {
+        for (std::size_t d = 0; d < digits; ++d) {
+            ++histograms[d * buckets + ((r->x >> (d * radix_bits)) & mask)];
+        }
+    }
+    record_type * source = first;
+    record_type * destination = tmp;
+    for (std::size_t d = 0; d < digits; ++d) {
+        const auto histogram = std::next(std::begin(histograms), std::ptrdiff_t(d * buckets));
+        const auto hend = std::next(histogram, std::ptrdiff_t(buckets));
+        if (std::find(histogram, hend, index(size)) != hend) {
+            continue;
+        }
+        index offset = 0;
+        for (auto h = histogram; h != hend; ++h) {
+            offset += std::exchange(*h, offset);
+        }
+        const std::size_t shift = d * radix_bits;
+        for (const record_type * r = source; r != source + size; ++r) {
+            destination[histogram[std::ptrdiff_t((r->x >> shift) & mask)]++] = *r;
+        }
+        std::swap(source, destination);
+    }
+    if (source != first) {
+        std::copy(source, source + size, first);
+    }
+}
+
+template< typename point, typename index >
+void radix(record< point, index > * first, record< point, index > * last, record< point, index > * tmp)
+{
+    std::vector< index > histograms;
+    radix(first, last, tmp, histograms);
+}
+
+// sort [first, last) by (x, y): runs of equal x (rare for scattered sites, usual for grids) are sorted by y afterwards
+template< typename iterator, typename index >
+void sort(const iterator points, record< typename std::iterator_traits< iterator >::value_type, index > * first,
+          record< typename std::iterator_traits< iterator >::value_type, index > * last,
+          record< typename std::iterator_traits< iterator >::value_type, index > * tmp, std::vector< index > & histograms)
+{
+    using point = typename std::iterator_traits< iterator >::value_type;
+    using record_type = record< point, index >;
+    using difference_type = typename std::iterator_traits< iterator >::difference_type;
+    constexpr std::ptrdiff_t min_radix_size = 256;
+    radix(first, last, tmp, histograms);
+    const auto y = [&] (const record_type & r) { return key(points[difference_type(r.i)].y); };
+    const auto less = [&] (const record_type & l, const record_type & r) { return y(l) < y(r); };
+    for (record_type * r = first; r != last;) {
+        record_type * const l = r;
+        while ((++r != last) && !(*l < *r)) {
+            continue;
+        }
+        if (r - l < 2) {
+            continue;
+        }
+        if (r - l < min_radix_size) {
+            std::sort(l, r, less);
+        } else { // same record type is sorted by y key in place of x one
+            const auto x = l->x;
+            std::for_each(l, r, [&] (record_type & _record) { _record.x = y(_record); });
+            radix(l, r, tmp + (l - first), histograms);
+            std::for_each(l, r, [&] (record_type & _record) { _record.x = x; });
+        }
+    }
+}
+
+template< typename iterator, typename index >
+void sort(const iterator points, record< typename std::iterator_traits< iterator >::value_type, index > * first,
+          record< typename std::iterator_traits< iterator >::value_type, index > * last,
+          record< typename std::iterator_traits< iterator >::value_type, index > * tmp)
+{
+    std::vector< index > histograms;
+    sort(points, first, last, tmp, histograms);
+}
+
+template< typename iterator, typename index >
+void make_records(const iterator first, record< typename std::iterator_traits< iterator >::value_type, index > * records,
+                  const std::size_t l, const std::size_t r)
+{
+    for (std::size_t i = l; i < r; ++i) {
+        records[i] = {key(first[typename std::iterator_traits< iterator >::difference_type(i)].x), index(i)};
+    }
+}
+
+// buffers of radix_permutation, which are kept by the caller, so repeated sorts of the same size do not allocate
+template< typename point, typename index >
+struct scratch
+{
+
+    std::vector< record< point, index > > records;
+    std::vector< index > histograms;
+
+};
+
+// permutation[j] is an index of j-th site in (x, y) order
+template< typename iterator, typename index >
+void radix_permutation(const iterator first, const iterator last, std::vector< index > & permutation,
+                       scratch< typename std::iterator_traits< iterator >::value_type, index > & _scratch)
+{
+    const auto size = std::size_t(std::distance(first, last));
+    assert(size <= std::size_t(std::numeric_limits< index >::max()));
+    auto & records = _scratch.records;
+    records.resize(size + size);
+    make_records(first, records.data(), 0, size);
+    sort(first, records.data(), records.data() + size, records.data() + size, _scratch.histograms);
+    permutation.resize(size);
+    for (std::size_t j = 0; j < size; ++j) {
+        permutation[j] = records[j].i;
+    }
+}
+
+template< typename iterator, typename index >
+void radix_permutation(const iterator first, const iterator last, std::vector< index > & permutation)
+{
+    scratch< typename std::iterator_traits< iterator >::value_type, index > scratch_;
+    radix_permutation(first, last, permutation, scratch_);
+}
+
+// sample sort: records are scattered into buckets between splitters, then buckets are sorted independently
+// sites with the same x always fall into the same bucket
+template< typename iterator, typename index >
+void parallel_permutation(const iterator first, const iterator last, std::vector< index > & permutation, thread_pool & pool)
+{
+    using point = typename std::iterator_traits< iterator >::value_type;
+    using record_type = record< point, index >;
+    const auto size = std::size_t(std::distance(first, last));
+    constexpr std::size_t min_chunk_size = std::size_t(1) << 15;
+    const std::size_t chunks = std::min(pool.size(), size / min_chunk_size);
+    if (chunks < 2) {
+        return radix_permutation(first, last, permutation);
+    }
+    assert(size <= std::size_t(std::numeric_limits< index >::max()));
+    const std::size_t buckets = 4 * chunks;
+    std::unique_ptr< record_type[] > records{new record_type[size + size]};
+    record_type * const source = records.get();
+    record_type * const destination = source + size;
+    const auto chunk = [&] (const std::size_t c) { return std::make_pair((size * c) / chunks, (size * (c + 1)) / chunks); };
+    pool.parallel_for(chunks, [&] (const std::size_t c, std::size_t)
+    {
+        const auto [l, r] = chunk(c);
+        make_records(first, source, l, r);
+    });
+    std::vector< record_type > splitters;
+    {
+        constexpr std::size_t oversampling = 32;
+        const std::size_t samples = buckets * oversampling;
+        splitters.reserve(samples);
+        for (std::size_t s = 0; s < samples; ++s) {
+            splitters.push_back(source[(size * s) / samples + (size / samples) / 2]);
+        }
+        std::sort(std::begin(splitters), std::end(splitters));
+        for (std::size_t b = 1; b < buckets; ++b) {
+            splitters[b - 1] = splitters[b * oversampling];
+        }
+        splitters.resize(buckets - 1);
+    }
+    const auto bucket = [&] (const record_type & r)
+    {
+        return std::size_t(std::distance(std::cbegin(splitters), std::upper_bound(std::cbegin(splitters), std::cend(splitters), r)));
+    };
+    std::vector< std::size_t > offsets(chunks * buckets + 1, 0); // bucket major
+    pool.parallel_for(chunks, [&] (const std::size_t c, std::size_t)
+    {
+        const auto [l, r] = chunk(c);
+        for (std::size_t i = l; i < r; ++i) {
+            ++offsets[bucket(source[i]) * chunks + c + 1];
+        }
+    });
+    std::partial_sum(std::cbegin(offsets), std::cend(offsets), std::begin(offsets));
+    pool.parallel_for(chunks, [&] (const std::size_t c, std::size_t)
+    {
+        const auto [l, r] = chunk(c);
+        std::vector< std::size_t > o(buckets);
+        for (std::size_t b = 0; b < buckets; ++b) {
+            o[b] = offsets[b * chunks + c];
+        }
+        for (std::size_t i = l; i < r; ++i) {
+            destination[o[bucket(source[i])]++] = source[i];
+        }
+    });
+    permutation.resize(size);
+    pool.parallel_for(buckets, [&] (const std::size_t b, std::size_t)
+    {
+        const std::size_t l = offsets[b * chunks];
+        const std::size_t r = offsets[(b + 1) * chunks];
+        sort(first, destination + l, destination + r, source + l);
+        for (std::size_t j = l; j < r; ++j) {
+            permutation[j] = destination[j].i;
+        }
+    });
+}
+
+// reorder [first, first + permutation.size()) in place: j-th element becomes permutation[j]-th one; values is a buffer, which can be reused
+template< typename iterator, typename index >
+void apply_permutation(const iterator first, const std::vector< index > & permutation,
+                       std::vector< typename std::iterator_traits< iterator >::value_type > & values)
+{
+    using difference_type = typename std::iterator_traits< iterator >::difference_type;
+    values.clear();
+    values.reserve(permutation.size());
+    for (const index i : permutation) {
+        values.push_back(std::move(first[difference_type(i)]));
+    }
+    std::move(std::begin(values), std::end(values), first);
+}
+
+template< typename iterator, typename index >
+void apply_permutation(const iterator first, const std::vector< index > & permutation)
+{
+    std::vector< typename std::iterator_traits< iterator >::value_type > values;
+    apply_permutation(first, permutation, values);
+}
+
+}
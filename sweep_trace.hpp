@@ -0,0 +1,231 @@
+#pragma once
+
+#include "sweepline.hpp"
+#include "site_file.hpp"
+
+#include <algorithm>
+#include <vector>
+#include <system_error>
+#include <stdexcept>
+
+#include <cassert>
+#include <cerrno>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// trace of a sweep: the statistics policy ring keeps the counters of sweep_statistics and the last records of sites and circle events
+// (see trace_event) in a buffer of fixed capacity, which is overwritten from the oldest record; a record is written by a few stores,
+// nothing is allocated during the sweep
+// binary file: header, then kept records from the oldest to the newest in native byte order; it is written by write(2) only,
+// so write_on_abort can leave the trace of a sweep, which is aborted by a failed assert; it is read back from a site_file::mapped_file
+namespace sweep_trace
+{
+
+using site_file::mapped_file;
+
+using kind = trace_event;
+
+struct record
+{
+
+    double x, y; // site or the rightmost point of the circle
+    kind kind_;
+    std::uint32_t size; // rays of a finished bundle, endpoints of the range for on_edge
+    std::uint32_t endpoints; // beachline after the record
+    std::uint32_t events; // queue after the record
+
+};
+
+static_assert(sizeof(record) == 32, "records are packed");
+
+struct header
+{
+
+    static constexpr char signature[8] = {'s', 'w', 'e', 'e', 'p', 't', 'r', 'c'};
+    static constexpr std::uint32_t current_version = 1;
+
+    char magic[8];
+    std::uint32_t version; // also detects foreign byte order
+    std::uint32_t record_size;
+    std::uint64_t size; // records in the file
+    std::uint64_t total; // records of the sweep, the first (total - size) ones are overwritten
+    std::uint64_t reserved[4];
+
+};
+
+static_assert(sizeof(header) == 64, "records are aligned by the header");
+
+struct ring
+        : sweep_statistics
+{
+
+    static constexpr bool tracing = true;
+
+    // capacity is rounded up to a power of two
+    explicit
+    ring(const size_type capacity = size_type(1) << 16)
+    {
+        resize(capacity);
+    }
+
+    void resize(const size_type capacity)
+    {
+        size_type size = 1;
+        while (size < capacity) {
+            size += size;
+        }
+        records_.assign(size, record{});
+        mask_ = size - 1;
+        total_ = 0;
+    }
+
+    void trace(const kind kind_, const double x, const double y, const size_type size, const size_type endpoints, const size_type events)
+    {
+        records_[total_ & mask_] = {x, y, kind_, std::uint32_t(size), std::uint32_t(endpoints), std::uint32_t(events)};
+        ++total_;
+    }
+
+    void clear()
+    {
+        sweep_statistics::clear();
+        total_ = 0;
+    }
+
+    std::uint64_t total() const { return total_; }
+    size_type size() const { return size_type(std::min(total_, std::uint64_t(mask_) + 1)); }
+
+    // i-th of the kept records from the oldest one
+    const record & operator [] (const size_type i) const
+    {
+        assert(i < size());
+        return records_[(total_ - size() + i) & mask_];
+    }
+
+    // whole file to fd, false on error (errno is set); it only calls write(2), so it is safe in a signal handler
+    bool write(const int fd) const noexcept
+    {
+        header header_;
+        std::memset(&header_, 0, sizeof header_);
+        std::memcpy(header_.magic, header::signature, sizeof header::signature);
+        header_.version = header::current_version;
+        header_.record_size = sizeof(record);
+        header_.size = size();
+        header_.total = total_;
+        const size_type oldest = size_type((total_ - header_.size) & mask_);
+        const size_type tail = std::min(size(), records_.size() - oldest); // the rest of the records is at the beginning of the buffer
+        return put(fd, &header_, sizeof header_)
+                && put(fd, records_.data() + oldest, tail * sizeof(record))
+                && put(fd, records_.data(), (size() - tail) * sizeof(record));
+    }
+
+    void write(const char * const path) const
+    {
+        const int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            throw std::system_error{errno, std::generic_category(), path};
+        }
+        if (!write(fd)) {
+            const int error = errno;
+            ::close(fd);
+            throw std::system_error{error, std::generic_category(), path};
+        }
+        if (::close(fd) != 0) {
+            throw std::system_error{errno, std::generic_category(), path};
+        }
+    }
+
+private :
+
+    std::vector< record > records_;
+    size_type mask_ = 0;
+    std::uint64_t total_ = 0;
+
+    static
+    bool put(const int fd, const void * const data, size_type size) noexcept
+    {
+        const char * p = static_cast< const char * >(data);
+        while (0 < size) {
+            const ::ssize_t written = ::write(fd, p, size);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            p += written;
+            size -= size_type(written);
+        }
+        return true;
+    }
+
+};
+
+inline const ring * aborted_ring = nullptr;
+inline const char * aborted_path = nullptr;
+
+// SIGABRT (e.g. a failed assert) writes ring_ to path (it should outlive the sweep), then the signal is raised again by default
+inline
+void write_on_abort(const ring & ring_, const char * const path)
+{
+    aborted_ring = &ring_;
+    aborted_path = path;
+    std::signal(SIGABRT, [] (const int signal)
+    {
+        const int fd = ::open(aborted_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (!(fd < 0)) {
+            aborted_ring->write(fd);
+            ::close(fd);
+        }
+        std::signal(signal, SIG_DFL);
+        std::raise(signal);
+    });
+}
+
+// header of a binary file, throws if the file is not of the format
+inline
+const header & get_header(const mapped_file & _file)
+{
+    if (_file.size() < sizeof(header)) {
+        throw std::runtime_error{"trace file: no header"};
+    }
+    const auto & header_ = *reinterpret_cast< const header * >(_file.data());
+    if (std::memcmp(header_.magic, header::signature, sizeof header::signature) != 0) {
+        throw std::runtime_error{"trace file: bad signature"};
+    }
+    if ((header_.version != header::current_version) || (header_.record_size != sizeof(record))) {
+        throw std::runtime_error{"trace file: unsupported version or byte order"};
+    }
+    return header_;
+}
+
+struct records
+{
+
+    const record * first;
+    const record * last;
+
+    const record * begin() const { return first; }
+    const record * end() const { return last; }
+
+    std::size_t size() const { return std::size_t(last - first); }
+
+};
+
+// records of the binary file in place
+inline
+records get_records(const mapped_file & _file)
+{
+    const header & header_ = sweep_trace::get_header(_file);
+    if ((_file.size() - sizeof(header)) / sizeof(record) < header_.size) {
+        throw std::runtime_error{"trace file: truncated"};
+    }
+    const auto first = reinterpret_cast< const record * >(_file.data() + sizeof(header));
+    return {first, first + header_.size};
+}
+
+}
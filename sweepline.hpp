@@ -22,6 +22,11 @@
 #pragma once
 
 #include "rb_tree.hpp"
+#include "b_tree.hpp"
+#include "heap.hpp"
+#include "index_list.hpp"
+#include "circumcircle.hpp"
+#include "predicates.hpp"
 
 #include <type_traits>
 #include <utility>
@@ -30,41 +35,327 @@
 #include <iterator>
 #include <algorithm>
 #include <numeric>
-#include <deque>
-#include <list>
+#include <limits>
+#include <vector>
+#include <optional>
 #ifdef DEBUG
 #include <iostream>
 #endif
 
 #include <cassert>
+#include <cstdint>
 #include <cmath>
 
+// event queue policies: event queue is an ordered map from vertices to bundles,
+// locator is used by hash based queues to find equivalent vertices, allocator is rebound to elements of the map
+
+template< typename allocator, typename type >
+using rebind_alloc = typename std::allocator_traits< allocator >::template rebind_alloc< type >;
+
+struct tree_event_queue
+{
+
+    template< typename key_type, typename mapped_type, typename compare, typename locator, typename allocator = std::allocator< char > >
+    using map = rb_tree::arena_map< key_type, mapped_type, compare, rebind_alloc< allocator, rb_tree::pair< const key_type, mapped_type > > >;
+
+};
+
+template< std::size_t arity = 4 >
+struct heap_event_queue
+{
+
+    template< typename key_type, typename mapped_type, typename compare, typename locator, typename allocator = std::allocator< char > >
+    using map = heap::map< key_type, mapped_type, compare, locator, arity, rebind_alloc< allocator, heap::pair< const key_type, mapped_type > > >;
+
+};
+
+// beachline policies: beachline is an ordered map from endpoints to events, iterators to which stay valid until they are erased
+
+struct tree_beachline
+{
+
+    template< typename key_type, typename mapped_type, typename compare, typename allocator = std::allocator< char > >
+    using map = rb_tree::arena_map< key_type, mapped_type, compare, rebind_alloc< allocator, rb_tree::pair< const key_type, mapped_type > > >;
+
+};
+
+// wide nodes of copied keys (B+-tree) for large beachlines: fewer cache misses per descent, but insertions and erasures shift keys within nodes
+// blocks are allocated by new, so only std::allocator is accepted
+template< std::size_t order = 8 >
+struct b_tree_beachline
+{
+
+    template< typename key_type, typename mapped_type, typename compare, typename allocator = std::allocator< char > >
+    using map = b_tree::map< key_type, mapped_type, compare, order >;
+
+};
+
+// statistics policies: counters of hot paths, which are readable through sweepline::statistics_ after operator ()
+// no_statistics costs nothing: all the counting is discarded at compile time
+// tracing policies (sweep_trace::ring in sweep_trace.hpp) also get statistics_.trace(event, x, y, size, endpoints, events)
+// for every site and circle event: the point, rays of a finished bundle, sizes of the beachline and of the queue after it
+
+enum class trace_event : std::uint32_t
+{
+    append, // sites by branches of begin_cell
+    prepend,
+    middle,
+    on_edge, // recorded before the check of precision
+    created, // circle events: the rightmost point of the circle
+    joined,
+    disabled,
+    finished,
+};
+
+struct no_statistics
+{
+
+    static constexpr bool enabled = false;
+    static constexpr bool tracing = false;
+
+    void clear() { ; }
+
+};
+
+struct sweep_statistics
+{
+
+    static constexpr bool enabled = true;
+    static constexpr bool tracing = false;
+
+    using size_type = std::size_t;
+    using histogram = std::vector< size_type >; // [i] is a number of cases of size i
+
+    // begin_cell branches
+    size_type append = 0;
+    size_type prepend = 0;
+    size_type middle = 0;
+    size_type on_edge = 0; // site falls onto an endpoint
+
+    // check_event outcomes
+    size_type diverging = 0; // not CW triple
+    size_type preceded = 0; // earlier event of an endpoint wins
+    size_type inserted = 0;
+    size_type joined = 0; // to an equivalent event
+
+    size_type disabled = 0; // false alarms
+    size_type comparisons = 0; // of endpoints and events in the trees and heaps
+
+    histogram bundles; // rays per finished event
+    histogram degrees; // edges per vertex
+    histogram ranges; // rays, which angles are compared in endpoint_range
+
+    size_type max_endpoints = 0; // beachline
+    size_type max_events = 0; // queue depth
+
+    static
+    void count(histogram & _histogram, const size_type i)
+    {
+        if (!(i < _histogram.size())) {
+            _histogram.resize(i + 1, 0);
+        }
+        ++_histogram[i];
+    }
+
+    void clear()
+    {
+        *this = {};
+    }
+
+};
+
+// diagram policies: keep_diagram leaves all the vertices and edges in vertices_ and edges_
+// stream_diagram< sink > passes every vertex to sink_.vertex(vertex_) as soon as it is made (k-th call is for vertex k)
+// and every edge to sink_.edge(edge_) as soon as both its ends are known (the rest at the end of the sweep),
+// ends of passed edges are numbers of vertices; vertices_ and edges_ hold only the ones, which are still referenced
+// from the beachline, in recycled slots, so the resident part of the diagram is bounded by the beachline
+
+// compact_diagram keeps the whole diagram as keep_diagram does, but in 32-bit handles (up to (2^32 - 1) / 3 sites):
+// sites of edges are indices relative to the first site of the sweep (so site should be a random access iterator),
+// vertices are stored in columns vertices_.x, vertices_.y and vertices_.R, vertices_[v] makes a copy
+
+// delaunay_diagram< sink > keeps neither vertices nor edges (vertices_ and edges_ stay empty): the dual triangulation is passed
+// to sink_.triangle(a, b, c) (sites in CCW order) as soon as the circle event of a vertex is finished,
+// sites of a vertex of degree k > 3 (cocircular ones) are passed as a fan of k - 2 triangles from one of them
+
+struct keep_diagram
+{
+
+    static constexpr bool streaming = false;
+    static constexpr bool compact = false;
+    static constexpr bool triangulation = false;
+
+    struct sink_type { };
+
+};
+
+template< typename sink >
+struct stream_diagram
+{
+
+    static constexpr bool streaming = true;
+    static constexpr bool compact = false;
+    static constexpr bool triangulation = false;
+
+    using sink_type = sink;
+
+};
+
+struct compact_diagram
+{
+
+    static constexpr bool streaming = false;
+    static constexpr bool compact = true;
+    static constexpr bool triangulation = false;
+
+    struct sink_type { };
+
+};
+
+template< typename sink >
+struct delaunay_diagram
+{
+
+    static constexpr bool streaming = false;
+    static constexpr bool compact = false;
+    static constexpr bool triangulation = true;
+
+    using sink_type = sink;
+
+};
+
 template< typename site,
           typename point = typename std::iterator_traits< site >::value_type,
-          typename value_type = decltype(std::declval< point >().x) >
+          typename value_type = decltype(std::declval< point >().x),
+          typename event_queue = tree_event_queue,
+          typename statistics = no_statistics,
+          typename diagram = keep_diagram,
+          typename beachline = tree_beachline,
+          typename allocator = std::allocator< char > >
 struct sweepline
 {
 
     static_assert(std::is_base_of< std::forward_iterator_tag, typename std::iterator_traits< site >::iterator_category >::value,
                   "multipass guarantee required");
 
+    static constexpr bool compact = diagram::compact;
+
+    static_assert(!compact || std::is_base_of< std::random_access_iterator_tag, typename std::iterator_traits< site >::iterator_category >::value,
+                  "compact diagram refers to sites by indices");
+
+    using sink_type = typename diagram::sink_type;
+
+    // all the containers allocate through it (rebound), e.g. std::pmr::polymorphic_allocator< char > over a caller-supplied region
+    using allocator_type = allocator;
+
     explicit
-    sweepline(value_type eps)
-        : less_{std::move(eps)}
+    sweepline(value_type eps, sink_type _sink = sink_type{}, const allocator_type & _allocator = allocator_type{})
+        : allocator_{_allocator}
+        , sink_{std::move(_sink)}
+        , less_{std::move(eps)}
     {
-        assert(!(eps < value_type(0)));
+        assert(!(less_.eps < value_type(0)));
     }
 
+    using coordinate_type = decltype(std::declval< point >().x);
+
+    // floating point value_type is promoted to double in intermediate calculations: float sites and vertices are stored compactly,
+    // but circumcenters and intersections of parabolas are not less precise, than for double ones
+    using promoted_type = decltype(std::declval< value_type >() * 0.0);
+
+    static_assert(std::is_floating_point< value_type >::value, "vertices have floating point coordinates");
+    static_assert(std::is_floating_point< coordinate_type >::value || (std::is_integral< coordinate_type >::value && (sizeof(coordinate_type) <= sizeof(std::int32_t))),
+                  "sites have floating point or (up to 32-bit) integral coordinates");
+
+    // eps for sites, which coordinates do not exceed magnitude by absolute value
+    // for double it is a relative precision of circumcenters of badly conditioned triangles,
+    // for float circumcenters are calculated in double, so it is enough to cover a few ulps of rounding them to float
+    // eps should be less than a distance between any two sites
+    static
+    value_type default_eps(const value_type & magnitude)
+    {
+        using std::sqrt;
+        const auto epsilon = std::max(promoted_type(4) * promoted_type(std::numeric_limits< value_type >::epsilon()),
+                                      sqrt(std::numeric_limits< promoted_type >::epsilon()));
+        return value_type(promoted_type(magnitude) * epsilon);
+    }
+
+    struct vertex_point // circumcenters of integral sites are not integral
+    {
+
+        value_type x, y;
+
+        bool operator < (const vertex_point & p) const
+        {
+            return std::tie(x, y) < std::tie(p.x, p.y);
+        }
+
+    };
+
     struct vertex // circumscribed circle
     {
 
-        point c; // circumcenter
+        std::conditional_t< std::is_integral< coordinate_type >::value, vertex_point, point > c; // circumcenter
         value_type R; // circumradius
 
     };
 
-    using vertices = std::deque< vertex >;
-    using pvertex = typename vertices::size_type;
+    using handle_type = std::uint32_t; // of compact diagram
+
+    template< typename type >
+    using vector = std::vector< type, rebind_alloc< allocator_type, type > >;
+
+    // structure of arrays: traversal of one coordinate touches only its column
+    struct vertex_columns
+    {
+
+        using coordinate = decltype(vertex::c.x);
+
+        vector< coordinate > x, y;
+        vector< value_type > R;
+
+        explicit
+        vertex_columns(const allocator_type & _allocator = allocator_type{})
+            : x(_allocator)
+            , y(_allocator)
+            , R(_allocator)
+        { ; }
+
+        handle_type size() const { return handle_type(R.size()); }
+        bool empty() const { return R.empty(); }
+
+        void reserve(const std::size_t n)
+        {
+            x.reserve(n);
+            y.reserve(n);
+            R.reserve(n);
+        }
+
+        void clear()
+        {
+            x.clear();
+            y.clear();
+            R.clear();
+        }
+
+        void push_back(const vertex & v)
+        {
+            x.push_back(v.c.x);
+            y.push_back(v.c.y);
+            R.push_back(v.R);
+        }
+
+        vertex operator [] (const handle_type v) const
+        {
+            return {{x[v], y[v]}, R[v]};
+        }
+
+    };
+
+    using vertices = std::conditional_t< compact, vertex_columns, vector< vertex > >;
+    using pvertex = std::conditional_t< compact, handle_type, typename vector< vertex >::size_type >;
+
+    using psite = std::conditional_t< compact, handle_type, site >;
 
     // ((l, r), (b, e)) is CW
     // (b == inf) means (b == (-infty, *)); (e == inf) means (e == (+infty, *))
@@ -72,20 +363,85 @@ struct sweepline
     struct edge
     {
 
-        site l, r;
+        psite l, r;
         pvertex b, e;
 
     };
 
-    using edges = std::deque< edge >;
-    using pedge = typename edges::size_type;
+    using edges = vector< edge >;
+    using pedge = std::conditional_t< compact, handle_type, typename edges::size_type >;
+
+    // both are contiguous (data() and size() can be passed as is) and reserved up to the bounds by operator ()
+    // clear() keeps capacity of them, of node pools of the beachline and of the event queue and of rays,
+    // so repeated runs on inputs of similar sizes do not allocate at all; shrink_to_fit() releases everything
+    const allocator_type allocator_;
 
-    vertices vertices_; // 0 <= size <= 2 * n - 2
+    vertices vertices_{allocator_}; // 0 <= size <= 2 * n - 2
     const pvertex inf = std::numeric_limits< pvertex >::max();
-    edges edges_; // n - 1 <= size <= 3 * n - 3
+    edges edges_{allocator_}; // n - 1 <= size <= 3 * n - 3
+
+    [[no_unique_address]] statistics statistics_; // no_statistics takes no space
+    [[no_unique_address]] sink_type sink_;
+
+    // the beachline is searched from the last inserted endpoint instead of from the root: fewer comparisons for spatially coherent inputs,
+    // where consecutive sites are close on the beachline (scanlines, sorted grids), but up to twice as many for random ones
+    bool finger_search = false;
+
+    // disabled events are not erased from the queue at once, but marked stale and skipped, when they reach its top, their endpoints are released at once;
+    // the queue is compacted, when stale events outnumber live ones, it should not be changed during a sweep
+    bool lazy_events = false;
 
 private :
 
+    static constexpr bool streaming = diagram::streaming;
+    static constexpr bool triangulation = diagram::triangulation;
+
+    // streaming only: slots of vertices_ and edges_ are reused
+    vector< pvertex > vertex_numbers_{allocator_}; // of vertices in slots
+    vector< std::size_t > vertex_references_{allocator_}; // open edges, plus one while the vertex is being made
+    vector< pvertex > free_vertices_{allocator_};
+    vector< pedge > free_edges_{allocator_};
+    vector< std::uint8_t > edge_rays_{allocator_}; // endpoints, which still refer to the edge
+    vector< pedge > last_edges_{allocator_};
+    pvertex vertex_count_ = 0;
+
+    std::size_t pushed_ = 0; // sites of the sweep in progress
+    std::optional< site > first_; // the first site, it makes a cell together with the second one
+
+    // compact diagram only: sites of edges are counted from the first one
+    psite site_handle(const site s) const
+    {
+        if constexpr (compact) {
+            return psite(std::distance(*first_, s));
+        } else {
+            return s;
+        }
+    }
+
+    const point & site_point(const psite s) const
+    {
+        if constexpr (compact) {
+            return *std::next(*first_, std::ptrdiff_t(s));
+        } else {
+            return *s;
+        }
+    }
+
+    template< typename F >
+    void count(F && f)
+    {
+        if constexpr (statistics::enabled) {
+            f(statistics_);
+        }
+    }
+
+    void trace(const trace_event event_, const value_type & x, const value_type & y, const std::size_t size = 0)
+    {
+        if constexpr (statistics::tracing) {
+            statistics_.trace(event_, x, y, size, endpoints_.size(), events_.size());
+        }
+    }
+
     struct endpoint
     {
 
@@ -99,7 +455,7 @@ private :
             const point & ll = *l;
             const point & rr = *r;
             using std::atan2;
-            return atan2(rr.x - ll.x, rr.y - ll.y);
+            return value_type(atan2(promoted_type(rr.x) - promoted_type(ll.x), promoted_type(rr.y) - promoted_type(ll.y)));
         }
 
     };
@@ -129,11 +485,8 @@ private :
                 return true;
             } else if (operator () (rx, lx)) {
                 return false;
-            } else if (operator () (ly, ry)) {
-                return true;
             } else {
-                assert(!operator () (ry, ly));
-                return false;
+                return operator () (ly, ry);
             }
         }
 
@@ -144,19 +497,17 @@ private :
 
         bool operator () (const point & l, const point & r, const point & p, const bool right) const
         {
+            // squared distances from the point of the bisector at p.y to r (ll) and to the sweep line (rr) are compared exactly
             const auto sqr_dist = [&] (const bool left) -> bool
             {
-                const point c = {(l.x + r.x) / value_type(2), (l.y + r.y) / value_type(2)};
-                value_type dx = c.x + (p.y - c.y) * (r.y - l.y) / (l.x - r.x);
-                const value_type & dxy = p.x - dx;
-                dx -= r.x;
-                const value_type & dy = r.y - p.y;
-                const value_type & ll = dy * dy + dx * dx;
-                const value_type & rr = dxy * dxy;
+                const auto compare = [&] (const promoted_type t)
+                {
+                    return predicates::breakpoint< promoted_type >(l.x, l.y, r.x, r.y, p.x, p.y, t);
+                };
                 if (left) {
-                    return rr + eps2 < ll;
+                    return 0 < compare(+promoted_type(eps2)); // rr + eps2 < ll
                 } else {
-                    return ll + eps2 < rr;
+                    return compare(-promoted_type(eps2)) < 0; // ll + eps2 < rr
                 }
             };
             if (operator () (l.x, r.x)) {
@@ -173,8 +524,8 @@ private :
                 }
             } else {
                 assert(operator () (l.y, r.y));
-                const value_type & ll = (l.y + r.y) / value_type(2);
-                const value_type & rr = p.y;
+                const value_type ll = value_type((promoted_type(l.y) + promoted_type(r.y)) / promoted_type(2));
+                const value_type rr = p.y;
                 if (right) {
                     return operator () (ll, rr);
                 } else {
@@ -195,54 +546,204 @@ private :
 
     } const less_;
 
+    struct counting_less
+            : less
+    {
+
+        std::size_t * comparisons;
+
+        template< typename ...arguments >
+        bool operator () (const arguments & ..._arguments) const
+        {
+            ++*comparisons;
+            return less::operator () (_arguments...);
+        }
+
+    };
+
+    using compare = std::conditional_t< statistics::enabled, counting_less, less >;
+
+    compare make_compare()
+    {
+        if constexpr (statistics::enabled) {
+            return {less_, &statistics_.comparisons};
+        } else {
+            return less_;
+        }
+    }
+
+    struct locate // vertices equivalent to a given one lie in the same or adjacent cells
+    {
+
+        const value_type eps;
+        const value_type size = eps * value_type(16);
+
+        explicit
+        locate(const less & _less)
+            : eps{_less.eps}
+        { ; }
+
+        static
+        std::size_t hash(const value_type & x, const value_type & y)
+        {
+            const std::hash< value_type > hash_;
+            const std::size_t h = hash_(x);
+            return h ^ (hash_(y) + 0x9E3779B97F4A7C15u + (h << 6) + (h >> 2));
+        }
+
+        std::size_t cell(const vertex & v) const
+        {
+            if (!(value_type(0) < size)) {
+                return hash(event_x(v), v.c.y);
+            }
+            using std::floor;
+            return hash(floor(event_x(v) / size), floor(v.c.y / size));
+        }
+
+        template< typename F >
+        void cells(const vertex & v, F && f) const
+        {
+            const value_type x = event_x(v);
+            const value_type & y = v.c.y;
+            if (!(value_type(0) < size)) {
+                f(hash(x, y));
+                return;
+            }
+            using std::floor;
+            const value_type cx = floor(x / size);
+            const value_type cy = floor(y / size);
+            const value_type margin = eps + eps;
+            const auto neighbour = [&] (const value_type & z, const value_type & cz) -> int
+            {
+                if (z - cz * size < margin) {
+                    return -1;
+                } else if ((cz + value_type(1)) * size - z < margin) {
+                    return +1;
+                } else {
+                    return 0;
+                }
+            };
+            const int dx = neighbour(x, cx);
+            const int dy = neighbour(y, cy);
+            f(hash(cx, cy));
+            if (dx != 0) {
+                f(hash(cx + value_type(dx), cy));
+            }
+            if (dy != 0) {
+                f(hash(cx, cy + value_type(dy)));
+                if (dx != 0) {
+                    f(hash(cx + value_type(dx), cy + value_type(dy)));
+                }
+            }
+        }
+
+    };
+
     struct pevent;
 
-    using endpoints = rb_tree::map< endpoint, pevent, less >;
+    using endpoints = typename beachline::template map< endpoint, pevent, compare, allocator_type >;
     using pendpoint = typename endpoints::iterator;
 
-    using rays = std::list< pendpoint >;
-    using pray = typename rays::iterator;
+    using rays = index_list::list< pendpoint, std::uint32_t, rebind_alloc< allocator_type, pendpoint > >; // rays of a bundle are adjacent in the list
+    using pray = typename rays::size_type;
 
     template< typename type >
     struct range { type l, r; };
 
     using bundle = range< const pray >;
 
-    using events = rb_tree::map< vertex, bundle const, less >;
+    using events = typename event_queue::template map< vertex, bundle const, compare, locate, allocator_type >;
 
     using pevent_base = typename events::iterator;
     struct pevent : pevent_base { pevent(const pevent_base it) : pevent_base{it} { ; } };
 
-    endpoints endpoints_{less_};
+    endpoints endpoints_{make_compare(), allocator_};
     const pendpoint nep = std::end(endpoints_);
+    pendpoint finger_ = nep; // the last inserted endpoint
 
-    rays rays_;
-    const pray nray = std::end(rays_);
-    pray rev = nray; // revocation boundary
+    rays rays_{allocator_};
+    const pray nray = rays_.end();
+    pray rev = nray; // revocation boundary: [rev, nray) is a free list
 
-    events events_{less_};
+    events events_{make_compare(), allocator_};
     const pevent nev = std::end(events_);
+    std::size_t stale_events_ = 0; // lazy_events only
+
+    // orientation of integral sites is exact
+    bool clockwise(const point & a, const point & b, const point & c) const
+    {
+        __extension__ using wide = __int128;
+        const auto cax = std::int64_t(a.x) - std::int64_t(c.x);
+        const auto cay = std::int64_t(a.y) - std::int64_t(c.y);
+        const auto cbx = std::int64_t(b.x) - std::int64_t(c.x);
+        const auto cby = std::int64_t(b.y) - std::int64_t(c.y);
+        return (wide(cax) * cby < wide(cay) * cbx);
+    }
 
     vertex make_vertex(const point & a,
                        const point & b,
                        const point & c) const
     {
-        const point ca = {a.x - c.x, a.y - c.y};
-        const point cb = {b.x - c.x, b.y - c.y};
-        vertex vertex_{{}, ca.y * cb.x - ca.x * cb.y};
-        if (less_.eps2 < vertex_.R) { // if CW
-            // interesting, that probability of this branch tends to 0.6 for points in general positions
-            vertex_.R += vertex_.R;
-            const value_type A = ca.x * ca.x + ca.y * ca.y;
-            const value_type B = cb.x * cb.x + cb.y * cb.y;
-            vertex_.c.x = (B * ca.y - A * cb.y) / vertex_.R;
-            vertex_.c.y = (cb.x * A - ca.x * B) / vertex_.R;
-            using std::sqrt; // std::sqrt is required by the IEEE standard be exact (error < 0.5 ulp)
-            vertex_.R = sqrt(vertex_.c.x * vertex_.c.x + vertex_.c.y * vertex_.c.y);
-            vertex_.c.x += c.x;
-            vertex_.c.y += c.y;
+        const promoted_type cax = promoted_type(a.x) - promoted_type(c.x);
+        const promoted_type cay = promoted_type(a.y) - promoted_type(c.y);
+        const promoted_type cbx = promoted_type(b.x) - promoted_type(c.x);
+        const promoted_type cby = promoted_type(b.y) - promoted_type(c.y);
+        promoted_type d = cay * cbx - cax * cby;
+        if constexpr (std::is_integral< coordinate_type >::value) {
+            if (!clockwise(a, b, c)) {
+                return {{}, value_type(0)};
+            }
+        } else if (!(0 < predicates::orientation< promoted_type >(a.x, a.y, b.x, b.y, c.x, c.y, less_.eps2))) { // not (eps2 < d) exactly
+            return {{}, std::min(value_type(d), less_.eps2)};
+        }
+        // CW: interesting, that probability of this branch tends to 0.6 for points in general positions
+        if (!(0 < d)) { // rounded d of a nearly degenerate triangle is zero or of the opposite sign to the exact one
+            d = predicates::determinant< promoted_type >(a.x, a.y, b.x, b.y, c.x, c.y);
+        }
+        d += d;
+        const promoted_type A = cax * cax + cay * cay;
+        const promoted_type B = cbx * cbx + cby * cby;
+        promoted_type x = (B * cay - A * cby) / d;
+        promoted_type y = (cbx * A - cax * B) / d;
+        using std::sqrt; // std::sqrt is required by the IEEE standard be exact (error < 0.5 ulp)
+        const promoted_type R = sqrt(x * x + y * y);
+        x += promoted_type(c.x);
+        y += promoted_type(c.y);
+        return {{value_type(x), value_type(y)}, value_type(R)};
+    }
+
+    // make_vertex(a0, b0, c0) and make_vertex(a1, b1, c1) at once
+    void make_vertices(const point & a0, const point & b0, const point & c0,
+                       const point & a1, const point & b1, const point & c1,
+                       vertex & v0, vertex & v1) const
+    {
+        if constexpr (std::is_integral< coordinate_type >::value) {
+            v0 = make_vertex(a0, b0, c0);
+            v1 = make_vertex(a1, b1, c1);
+        } else {
+            const promoted_type ax[2] = {a0.x, a1.x};
+            const promoted_type ay[2] = {a0.y, a1.y};
+            const promoted_type bx[2] = {b0.x, b1.x};
+            const promoted_type by[2] = {b0.y, b1.y};
+            const promoted_type cx[2] = {c0.x, c1.x};
+            const promoted_type cy[2] = {c0.y, c1.y};
+            promoted_type x[2], y[2], R[2], d[2];
+            circumcircle::pair(ax, ay, bx, by, cx, cy, x, y, R, d);
+            const auto set = [&] (vertex & vertex_, const std::size_t i)
+            {
+                if (0 < predicates::orientation(ax[i], ay[i], bx[i], by[i], cx[i], cy[i], promoted_type(less_.eps2))) { // if CW
+                    if (!(0 < d[i])) { // see make_vertex
+                        vertex_ = make_vertex(i == 0 ? a0 : a1, i == 0 ? b0 : b1, i == 0 ? c0 : c1);
+                        return;
+                    }
+                    vertex_ = {{value_type(x[i]), value_type(y[i])}, value_type(R[i])};
+                } else {
+                    vertex_ = {{}, std::min(value_type(d[i]), less_.eps2)};
+                }
+            };
+            set(v0, 0);
+            set(v1, 1);
         }
-        return vertex_;
     }
 
     void add_ray(const pray rr, const pendpoint l)
@@ -251,8 +752,8 @@ private :
         if (nray == rev) {
             rays_.insert(rr, l);
         } else {
-            *rev = l;
-            rays_.splice(rr, rays_, rev++);
+            rays_[rev] = l;
+            rays_.splice(rr, std::exchange(rev, rays_.next(rev)));
         }
     }
 
@@ -262,65 +763,150 @@ private :
             return {rays_.insert(nray, l), rays_.insert(nray, r)};
         } else {
             const pray ll = rev;
-            *ll = l;
-            if (++rev == nray) {
+            rays_[ll] = l;
+            if ((rev = rays_.next(rev)) == nray) {
                 return {ll, rays_.insert(nray, r)};
             } else {
-                *rev = r;
-                return {ll, rev++};
+                rays_[rev] = r;
+                return {ll, std::exchange(rev, rays_.next(rev))};
             }
         }
     }
 
     void remove_bundle(const bundle & b)
     {
-        rays_.splice(nray, rays_, b.l, std::next(b.r));
+        rays_.splice(nray, b.l, rays_.next(b.r));
         if (rev == nray) {
             rev = b.l;
         }
     }
 
-    pevent disable_event(const pevent ev)
+    bool has_ray(const bundle & b, const pendpoint ep) const
+    {
+        const pray r = rays_.next(b.r);
+        for (pray l = b.l; l != r; l = rays_.next(l)) {
+            if (rays_[l] == ep) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // the first ray of the bundle of a stale event is nep, the rest of them are kept until the event is dropped
+    bool stale(const pevent ev) const
+    {
+        return rays_[ev->v.l] == nep;
+    }
+
+    void drop_event(const pevent ev)
+    {
+        assert(stale(ev));
+        remove_bundle(ev->v);
+        events_.erase(ev);
+        --stale_events_;
+    }
+
+    void compact_events()
+    {
+        events_.erase_if([&] (const auto & event_) -> bool
+        {
+            if (rays_[event_.v.l] != nep) {
+                return false;
+            }
+            remove_bundle(event_.v);
+            return true;
+        });
+        stale_events_ = 0;
+    }
+
+    // lazy_events only: equivalent stale events are dropped
+    pevent find_event(const vertex & vertex_)
+    {
+        pevent ev = events_.find(vertex_);
+        if (lazy_events) {
+            while ((ev != nev) && stale(ev)) {
+                drop_event(ev);
+                ev = events_.find(vertex_);
+            }
+        }
+        return ev;
+    }
+
+    // lazy_events only: a stale event equivalent to the vertex, which is not found (equivalence is not transitive), can prevent insertion
+    pevent insert_event(const vertex & vertex_, const bundle & b)
+    {
+        for (;;) {
+            const auto ev = events_.insert({vertex_, b});
+            if (ev.v || !lazy_events || !stale(ev.k)) {
+                assert(ev.v);
+                return ev.k;
+            }
+            drop_event(ev.k);
+        }
+    }
+
+    void disable_event(const pevent ev)
     {
         assert(ev != nev);
+        count([] (auto & _statistics) { ++_statistics.disabled; });
+        trace(trace_event::disabled, event_x(ev->k), ev->k.c.y);
         const bundle & b = ev->v;
         assert(b.l != b.r);
         assert(nray != b.r);
+        if (lazy_events) {
+            const pray r = rays_.next(b.r);
+            for (pray l = b.l; l != r; l = rays_.next(l)) {
+                const pendpoint ep = rays_[l];
+                assert(ep->v == ev);
+                ep->v = nev;
+            }
+            rays_[b.l] = nep;
+            if (events_.size() < 2 * ++stale_events_) {
+                compact_events();
+            }
+            return;
+        }
         remove_bundle(b);
-        assert(std::next(b.r) == nray);
-        for (auto l = b.l; l != nray; ++l) {
-            const pendpoint ep = *l;
+        assert(rays_.next(b.r) == nray);
+        for (pray l = b.l; l != nray; l = rays_.next(l)) {
+            const pendpoint ep = rays_[l];
             assert(ep->v == ev);
             ep->v = nev;
         }
-        return events_.erase(ev);
+        events_.erase(ev);
     }
 
     void check_event(const pendpoint l, const pendpoint r)
+    {
+        assert(std::next(l) == r);
+        check_event(l, r, make_vertex(*l->k.l, *l->k.r, *r->k.r));
+    }
+
+    // vertex_ is make_vertex(*l->k.l, *l->k.r, *r->k.r)
+    void check_event(const pendpoint l, const pendpoint r, vertex vertex_)
     {
         assert(std::next(l) == r);
         auto & ll = *l;
         auto & rr = *r;
         assert(ll.k.r == rr.k.l);
-        vertex vertex_ = make_vertex(*ll.k.l, *ll.k.r, *rr.k.r);
         if (less_.eps2 < vertex_.R) {
-            const value_type & x = event_x(vertex_);
-            const auto le = events_.find(vertex_);
+            const auto le = find_event(vertex_);
             const auto deselect_event = [&] (const pevent ev) -> bool
             {
                 if (ev != nev) {
                     if (ev != le) {
-                        const value_type & xx = event_x(ev->k);
-                        if (less_(xx, x)) {
+                        // events with equivalent x (more probable for float) are ordered by y, as in the queue
+                        if (less_(ev->k, vertex_)) {
                             return true;
                         }
-                        assert(less_(x, xx)); // not equiv
+                        // ev can be equivalent to vertex_, but not to le: equivalence is not transitive
                         disable_event(ev);
                     }
                 }
                 return false;
             };
             if (deselect_event(ll.v) || deselect_event(rr.v)) {
+                count([] (auto & _statistics) { ++_statistics.preceded; });
                 if (le != nev) {
                     disable_event(le);
                 }
@@ -328,10 +914,16 @@ private :
                 if (le == nev) {
                     assert(ll.v == nev);
                     assert(rr.v == nev);
-                    const auto ev = events_.insert({std::move(vertex_), add_bundle(l, r)});
-                    assert(ev.v);
-                    ll.v = rr.v = ev.k;
+                    ll.v = rr.v = insert_event(vertex_, add_bundle(l, r));
+                    count([&] (auto & _statistics)
+                    {
+                        ++_statistics.inserted;
+                        _statistics.max_events = std::max(_statistics.max_events, events_.size());
+                    });
+                    trace(trace_event::created, event_x(vertex_), vertex_.c.y);
                 } else {
+                    count([] (auto & _statistics) { ++_statistics.joined; });
+                    trace(trace_event::joined, event_x(vertex_), vertex_.c.y);
                     const bundle & b = le->v;
                     const auto set_event = [&] (pevent & ev, const pendpoint ep)
                     {
@@ -340,31 +932,121 @@ private :
                             add_ray(b.r, ep);
                         } else {
                             assert(ev == le);
-                            assert(std::find(b.l, std::next(b.r), ep) != std::next(b.r));
+                            assert(has_ray(b, ep));
                         }
                     };
                     set_event(ll.v, l);
                     set_event(rr.v, r);
                 }
             }
+        } else {
+            count([] (auto & _statistics) { ++_statistics.diverging; });
         }
     }
 
     pedge add_edge(const site l, const site r, const pvertex v)
     {
         assert(l != r);
+        if constexpr (triangulation) {
+            return pedge(0);
+        }
         const point & ll = *l;
         const point & rr = *r;
-        const pedge e = edges_.size();
-        if (std::tie(ll.y, rr.x) < std::tie(rr.y, ll.x)) {
-            edges_.push_back({l, r, v, inf});
-        } else {
-            edges_.push_back({r, l, inf, v});
+        const psite lh = site_handle(l);
+        const psite rh = site_handle(r);
+        const edge edge_ = (std::tie(ll.y, rr.x) < std::tie(rr.y, ll.x)) ? edge{lh, rh, v, inf} : edge{rh, lh, inf, v};
+        if constexpr (streaming) {
+            const std::uint8_t rays = (v == inf) ? 2 : 1; // add_cell corrects it for sites on a vertical line
+            if (v != inf) {
+                ++vertex_references_[v];
+            }
+            if (!free_edges_.empty()) {
+                const pedge e = free_edges_.back();
+                free_edges_.pop_back();
+                edges_[e] = edge_;
+                edge_rays_[e] = rays;
+                return e;
+            }
+            edge_rays_.push_back(rays);
         }
+        const pedge e = pedge(edges_.size());
+        edges_.push_back(edge_);
         return e;
     }
 
+    pvertex add_vertex(const vertex & vertex_)
+    {
+        if constexpr (triangulation) {
+            return pvertex(0);
+        } else if constexpr (streaming) {
+            sink_.vertex(vertex_);
+            if (!free_vertices_.empty()) {
+                const pvertex v = free_vertices_.back();
+                free_vertices_.pop_back();
+                vertices_[v] = vertex_;
+                vertex_numbers_[v] = vertex_count_++;
+                vertex_references_[v] = 1;
+                return v;
+            }
+            vertex_numbers_.push_back(vertex_count_++);
+            vertex_references_.push_back(1);
+        }
+        const pvertex v = pvertex(vertices_.size());
+        vertices_.push_back(vertex_);
+        return v;
+    }
+
+    void clear_slots()
+    {
+        vertices_.clear();
+        edges_.clear();
+        vertex_numbers_.clear();
+        vertex_references_.clear();
+        free_vertices_.clear();
+        free_edges_.clear();
+        edge_rays_.clear();
+    }
+
+    void release_vertex(const pvertex v)
+    {
+        if constexpr (streaming) {
+            assert(0 < vertex_references_[v]);
+            if (--vertex_references_[v] == 0) {
+                free_vertices_.push_back(v);
+            }
+        }
+    }
+
+    // streaming only: the edge is passed to the sink, then its slot is reused
+    void emit_edge(const pedge e)
+    {
+        edge edge_ = edges_[e];
+        for (pvertex * const v : {&edge_.b, &edge_.e}) {
+            if (*v != inf) {
+                release_vertex(*v);
+                *v = vertex_numbers_[*v];
+            }
+        }
+        free_edges_.push_back(e);
+        sink_.edge(edge_);
+    }
+
     void truncate_edge(const pedge e, const pvertex v)
+    {
+        if constexpr (triangulation) {
+            return;
+        }
+        set_edge_end(e, v);
+        if constexpr (streaming) {
+            ++vertex_references_[v];
+            assert(0 < edge_rays_[e]);
+            if (--edge_rays_[e] == 0) {
+                emit_edge(e);
+            }
+        }
+    }
+
+    void set_edge_end(const pedge e, const pvertex v)
     {
         assert(v != inf);
         edge & edge_ = edges_[e];
@@ -376,9 +1058,9 @@ private :
             assert(edge_.e != v);
             edge_.b = v;
         } else {
-            const point & l = *edge_.l;
-            const point & r = *edge_.r;
-            const point & c = vertices_[v].c;
+            const point & l = site_point(edge_.l);
+            const point & r = site_point(edge_.r);
+            const auto c = vertices_[v].c;
             assert(!(r.y < l.y));
             if (r.x < l.x) {
                 if (c.y < l.y) {
@@ -408,7 +1090,7 @@ private :
                               const site l, const site r,
                               const pedge e)
     {
-        return endpoints_.force_insert(ep, {{l, r, e}, nev});
+        return finger_ = endpoints_.force_insert(ep, {{l, r, e}, nev});
     }
 
     pendpoint add_cell(const site c, const site s)
@@ -419,6 +1101,8 @@ private :
         if (less_(c->x, s->x))  {
             const pendpoint rr = insert_endpoint(nep, s, c, e);
             assert(std::next(r) == rr);
+        } else if constexpr (streaming) {
+            edge_rays_[e] = 1;
         }
         return r;
     }
@@ -426,18 +1110,28 @@ private :
     void begin_cell(const site s)
     {
         assert(!endpoints_.empty());
-        auto lr = endpoints_.equal_range(*s);
+        auto lr = finger_search ? endpoints_.equal_range_from(finger_, *s) : endpoints_.equal_range(*s);
         if (lr.l == lr.r) {
             if (lr.l == nep) { // append to the rightmost endpoint
+                count([] (auto & _statistics) { ++_statistics.append; });
+                trace(trace_event::append, s->x, s->y);
                 --lr.l;
                 lr.r = add_cell(lr.l->k.r, s);
             } else if (lr.l == std::begin(endpoints_)) { // prepend to the leftmost endpoint
+                count([] (auto & _statistics) { ++_statistics.prepend; });
+                trace(trace_event::prepend, s->x, s->y);
                 const site c = lr.r->k.l;
                 const pedge e = add_edge(s, c, inf);
                 const pendpoint ll = insert_endpoint(lr.r, c, s, e);
                 lr.l = insert_endpoint(lr.r, s, c, e);
                 assert(std::next(ll) == lr.l);
             } else { // insert in the middle of the beachline (hottest branch in general case)
+                count([&] (auto & _statistics)
+                {
+                    ++_statistics.middle;
+                    _statistics.max_endpoints = std::max(_statistics.max_endpoints, endpoints_.size() + 2);
+                });
+                trace(trace_event::middle, s->x, s->y);
                 --lr.l;
                 const site c = lr.l->k.r;
                 assert(c == lr.r->k.l);
@@ -445,13 +1139,23 @@ private :
                 const pendpoint ll = insert_endpoint(lr.r, c, s, e);
                 const pendpoint rr = insert_endpoint(lr.r, s, c, e);
                 assert(std::next(ll) == rr);
-                check_event(lr.l, ll);
-                check_event(rr, lr.r);
+                vertex lv, rv; // both triples are independent of events
+                make_vertices(*lr.l->k.l, *c, *s, *s, *c, *lr.r->k.r, lv, rv);
+                check_event(lr.l, ll, std::move(lv));
+                check_event(rr, lr.r, std::move(rv));
                 return;
             }
             check_event(lr.l, lr.r);
         } else {
+            if constexpr (statistics::tracing) { // endpoints of the range: more than one, if the check fires
+                trace(trace_event::on_edge, s->x, s->y, size_type(std::distance(lr.l, lr.r)));
+            }
             assert(std::next(lr.l) == lr.r); // if fires, then there is problem with precision
+            count([&] (auto & _statistics)
+            {
+                ++_statistics.on_edge;
+                _statistics.max_endpoints = std::max(_statistics.max_endpoints, endpoints_.size() + 1);
+            });
             const auto & endpoint_ = *lr.l;
             if (endpoint_.v != nev) {
                 assert(less_(s->x, event_x(endpoint_.v->k)));
@@ -459,14 +1163,18 @@ private :
             }
             vertex vertex_ = make_vertex(*s, *endpoint_.k.l, *endpoint_.k.r);
             assert(less_.eps2 < vertex_.R);
-            assert(events_.find(vertex_) == nev);
-            assert(!less_(s->x, s->y, event_x(vertex_), vertex_.c.y)); // vertex and site are equivalent
-            assert(!less_(event_x(vertex_), vertex_.c.y, s->x, s->y)); // vertex and site are equivalent
-            const pvertex v = vertices_.size();
-            vertices_.push_back(std::move(vertex_));
+            assert((events_.find(vertex_) == nev) || (lazy_events && stale(events_.find(vertex_))));
+            // vertex and site are equivalent (for zero eps they are equal up to rounding of the vertex)
+            assert(!(value_type(0) < less_.eps) || !less_(s->x, s->y, event_x(vertex_), vertex_.c.y));
+            assert(!(value_type(0) < less_.eps) || !less_(event_x(vertex_), vertex_.c.y, s->x, s->y));
+            if constexpr (triangulation) {
+                add_triangle(endpoint_.k.l, endpoint_.k.r, s); // s is the last site of the circle, as in add_triangles
+            }
+            const pvertex v = add_vertex(vertex_);
             truncate_edge(endpoint_.k.e, v);
             const pedge le = add_edge(endpoint_.k.l, s, v);
             const pedge re = add_edge(s, endpoint_.k.r, v);
+            release_vertex(v);
             const pendpoint ep = insert_endpoint(lr.r, s, endpoint_.k.r, re);
             assert(std::next(ep) == lr.r);
             endpoints_.erase(std::exchange(lr.l, insert_endpoint(ep, endpoint_.k.l, s, le)));
@@ -485,27 +1193,34 @@ private :
     {
         assert(l != nray);
         assert(r != nray);
-        assert(std::next(r) == nray);
+        assert(rays_.next(r) == nray);
         assert(l != r);
-        if (std::next(l) == r) {
-            assert(std::next(*l) == *r);
+        if (rays_.next(l) == r) {
+            assert(std::next(rays_[l]) == rays_[r]);
         } else {
-            const auto angle_less = [] (const pendpoint ll, const pendpoint rr) -> bool
+            value_type lmin = rays_[l]->k.angle();
+            value_type rmax = lmin;
+            count([&] (auto & _statistics)
             {
-                return ll->k.angle() < rr->k.angle();
-            };
-#if 0
-            rays crays_;
-            crays_.splice(std::cend(crays_), rays_, l, nray);
-            crays_.sort(angle_less);
-            l = std::begin(crays_);
-            rays_.splice(nray, std::move(crays_));
-            r = std::prev(nray);
-#else
-            std::tie(l, r) = std::minmax_element(l, nray, angle_less);
-#endif
+                size_type n = 0;
+                for (pray i = l; i != nray; i = rays_.next(i)) {
+                    ++n;
+                }
+                _statistics.count(_statistics.ranges, n);
+            });
+            r = l;
+            for (pray i = rays_.next(l); i != nray; i = rays_.next(i)) {
+                const value_type angle = rays_[i]->k.angle();
+                if (angle < lmin) {
+                    lmin = angle;
+                    l = i;
+                } else if (!(angle < rmax)) { // the last largest one, as std::minmax_element does
+                    rmax = angle;
+                    r = i;
+                }
+            }
         }
-        return {*l, *r};
+        return {rays_[l], rays_[r]};
     }
 
     bool check_endpoint_range(const pevent ev, pendpoint l, const pendpoint r) const
@@ -531,26 +1246,63 @@ private :
         return true;
     }
 
+    // sites of a vertex come in CW order
+    void add_triangle(const site a, const site b, const site c)
+    {
+        sink_.triangle(a, c, b);
+    }
+
+    // sites of the circle are l->k.l, then k.r of every endpoint in [l, r], then s if on_site
+    void add_triangles(pendpoint l, const pendpoint r, const site s, const bool on_site)
+    {
+        const site a = l->k.l;
+        site b = l->k.r;
+        while (l != r) {
+            const site c = (++l)->k.r;
+            add_triangle(a, b, c);
+            b = c;
+        }
+        if (on_site) {
+            add_triangle(a, b, s);
+        }
+    }
+
+    // site s lies on the vertex if on_site
     void finish_cells(const pevent ev,
                       const vertex & _vertex,
                       const bundle & b,
-                      const site l, const site r)
+                      const site s, const bool on_site)
     {
         remove_bundle(b);
         auto lr = endpoint_range(b.l, b.r);
         assert(check_endpoint_range(ev, lr.l, lr.r));
-        const pvertex v = vertices_.size();
-        vertices_.push_back(_vertex);
+        const pvertex v = add_vertex(_vertex);
+        const value_type x = event_x(_vertex), y = _vertex.c.y; // _vertex is in the erased event
         events_.erase(ev);
         const site ll = lr.l->k.l;
         const site rr = lr.r->k.r;
+        if constexpr (triangulation) {
+            add_triangles(lr.l, lr.r, s, on_site);
+        }
         ++lr.r;
+        const pendpoint finger = finger_; // it stays near the last site, unless it is erased
+        bool moved = false;
+        size_type rays = 0;
         do {
+            moved = moved || (lr.l == finger);
             truncate_edge(lr.l->k.e, v);
             endpoints_.erase(lr.l++);
+            ++rays;
         } while (lr.l != lr.r);
-        if (l == r) {
+        count([&] (auto & _statistics)
+        {
+            _statistics.count(_statistics.bundles, rays);
+            _statistics.count(_statistics.degrees, rays + (on_site ? 2 : 1));
+        });
+        trace(trace_event::finished, x, y, rays);
+        if (!on_site) {
             lr.l = insert_endpoint(lr.r, ll, rr, add_edge(ll, rr, v));
+            release_vertex(v);
             if (lr.l != std::begin(endpoints_)) {
                 check_event(std::prev(lr.l), lr.l);
             }
@@ -558,8 +1310,9 @@ private :
                 check_event(lr.l, lr.r);
             }
         } else {
-            const pendpoint ep = insert_endpoint(lr.r, l, rr, add_edge(l, rr, v));
-            lr.l = insert_endpoint(ep, ll, l, add_edge(ll, l, v));
+            const pendpoint ep = insert_endpoint(lr.r, s, rr, add_edge(s, rr, v));
+            lr.l = insert_endpoint(ep, ll, s, add_edge(ll, s, v));
+            release_vertex(v);
             assert(std::next(lr.l) == ep);
             if (lr.l != std::begin(endpoints_)) {
                 check_event(std::prev(lr.l), lr.l);
@@ -568,10 +1321,16 @@ private :
                 check_event(ep, lr.r);
             }
         }
+        if (!moved) {
+            finger_ = finger;
+        }
     }
 
     bool check_last_endpoints() const
     {
+        if constexpr (triangulation) {
+            return true;
+        }
         for (const auto & ep : endpoints_) {
             const edge & e = edges_[ep.k.e];
             if ((e.b != inf) && (e.e != inf)) {
@@ -584,12 +1343,16 @@ private :
         return true;
     }
 
-    bool process_events(const site l, const site r)
+    bool process_events(const site s)
     {
         if (!events_.empty()) {
-            const point & point_ = *l;
+            const point & point_ = *s;
             do {
                 const pevent ev = std::begin(events_);
+                if (lazy_events && stale(ev)) {
+                    drop_event(ev);
+                    continue;
+                }
                 const auto & event_ = *ev;
                 const value_type & x = event_x(event_.k);
                 if (less_(point_.x, x)) {
@@ -599,11 +1362,11 @@ private :
                     if (less_(point_.y, y)) {
                         break;
                     } else if (!less_(y, point_.y)) {
-                        finish_cells(ev, event_.k, event_.v, l, r);
+                        finish_cells(ev, event_.k, event_.v, s, true);
                         return false;
                     }
                 }
-                finish_cells(ev, event_.k, event_.v, l, l);
+                finish_cells(ev, event_.k, event_.v, s, false);
             } while (!events_.empty());
         }
         return true;
@@ -611,46 +1374,209 @@ private :
 
 public :
 
+    using size_type = std::size_t;
+
+    // bytes of the containers for n sites, if they are reserved by reserve(n, true)
+    struct capacity
+    {
+
+        size_type endpoints, events, rays, vertices, edges;
+
+        size_type total() const { return endpoints + events + rays + vertices + edges; }
+
+    };
+
+private :
+
+    // numbers of elements: beachline has less than 2 * n endpoints, a pending event has at least two of them in its bundle,
+    // lazy_events may keep as many stale events (and their rays) as live ones; streaming slots are bounded as kept vertices and edges
+    static capacity worst_case_sizes(const size_type n, const bool lazy)
+    {
+        if (n < 2) {
+            return {0, 0, 0, 0, 0};
+        }
+        const size_type front = n + n;
+        const size_type queue = lazy ? (front + front) : front;
+        const size_type vertices = triangulation ? 0 : (n + n);
+        const size_type edges = triangulation ? 0 : (3 * n);
+        return {front, queue, queue + queue, vertices, edges};
+    }
+
+public :
+
+    // upper bounds of memory of the containers, which reserve(n, true) takes at once: the sweep of n sites does not allocate then,
+    // so it can run against a fixed region (e.g. std::pmr::monotonic_buffer_resource) without a risk of running out of it in the middle
+    static capacity worst_case(const size_type n, const bool lazy = false)
+    {
+        const capacity sizes = worst_case_sizes(n, lazy);
+        size_type vertex_size = sizeof(vertex);
+        if constexpr (compact) {
+            vertex_size = 2 * sizeof(typename vertex_columns::coordinate) + sizeof(value_type);
+        }
+        size_type edge_size = sizeof(edge);
+        if constexpr (streaming) {
+            vertex_size += 2 * sizeof(pvertex) + sizeof(std::size_t);
+            edge_size += 2 * sizeof(pedge) + sizeof(std::uint8_t);
+        }
+        return {endpoints::reserved_bytes(sizes.endpoints), events::reserved_bytes(sizes.events), rays::reserved_bytes(pray(sizes.rays)),
+                sizes.vertices * vertex_size, sizes.edges * edge_size};
+    }
+
+    // beachline holds O(sqrt(n)) endpoints on average (about 2 * sqrt(n) for uniformly distributed sites, up to 5 * sqrt(n) for grids)
+    // number of pending events never exceeds number of endpoints, though total number of events is up to 2 * n - 2
+    // trees allocate nodes from contiguous blocks growing geometrically, so underestimation costs only a few more allocations
+    // vertices and edges are reserved exactly up to the bounds above: 2 * n - 2 and 3 * n - 3
+    // worst_case reserves everything up to worst_case_sizes(n), then the estimates of later calls fit into it
+    void reserve(const size_type n, const bool worst_case = false)
+    {
+        if (worst_case) {
+            const capacity sizes = worst_case_sizes(n, lazy_events);
+            endpoints_.reserve(sizes.endpoints);
+            events_.reserve(sizes.events);
+            rays_.reserve(pray(sizes.rays));
+            vertices_.reserve(sizes.vertices);
+            edges_.reserve(sizes.edges);
+            if constexpr (streaming) {
+                vertex_numbers_.reserve(sizes.vertices);
+                vertex_references_.reserve(sizes.vertices);
+                free_vertices_.reserve(sizes.vertices);
+                free_edges_.reserve(sizes.edges);
+                edge_rays_.reserve(sizes.edges);
+                last_edges_.reserve(sizes.edges);
+            }
+            return;
+        }
+        using std::sqrt;
+        const auto front = std::min(size_type(4 * sqrt(double(n))) + 1, n + n);
+        endpoints_.reserve(front);
+        events_.reserve(front);
+        rays_.reserve(pray(front + front));
+        if constexpr (triangulation) {
+            return;
+        } else if constexpr (streaming) {
+            vertices_.reserve(front);
+            edges_.reserve(front);
+        } else if (1 < n) {
+            vertices_.reserve(n + n - 2);
+            edges_.reserve(3 * n - 3);
+        }
+    }
+
+    // incremental sweep: sites are passed by push() one by one in (x, y) order, then finish() completes the diagram
+    // after push() returns, only sites of the beachline (see for_each_front_site) and of edges_ are dereferenced
+    void push(const site s)
+    {
+        assert(!compact || (pushed_ < std::numeric_limits< handle_type >::max() / 3)); // edges are counted by handles too
+        if (pushed_ == 0) {
+            assert(endpoints_.empty());
+            assert(vertices_.empty());
+            assert(edges_.empty());
+            vertex_count_ = 0;
+            first_.emplace(s);
+        } else if (pushed_ == 1) {
+            add_cell(*first_, s);
+        } else if (process_events(s)) {
+            begin_cell(s);
+        }
+        ++pushed_;
+    }
+
+    void finish()
+    {
+        if (1 < pushed_) {
+            while (!events_.empty()) {
+                const pevent ev = std::begin(events_);
+                if (lazy_events && stale(ev)) {
+                    drop_event(ev);
+                    continue;
+                }
+                const auto & event_ = *ev;
+                finish_cells(ev, event_.k, event_.v, *first_, false);
+            }
+            assert(stale_events_ == 0);
+            //assert(std::is_sorted(std::begin(vertices_), nv, less_)); // almost true
+            assert(rev == rays_.begin());
+            assert(check_last_endpoints());
+            if constexpr (streaming) { // edges of unbounded cells
+                last_edges_.clear();
+                for (const auto & ep : endpoints_) {
+                    last_edges_.push_back(ep.k.e);
+                }
+                std::sort(std::begin(last_edges_), std::end(last_edges_));
+                last_edges_.erase(std::unique(std::begin(last_edges_), std::end(last_edges_)), std::end(last_edges_));
+                for (const pedge e : last_edges_) {
+                    emit_edge(e);
+                }
+                assert(free_vertices_.size() == vertices_.size());
+                assert(free_edges_.size() == edges_.size());
+                clear_slots();
+            }
+            endpoints_.reset();
+            finger_ = nep;
+        }
+        pushed_ = 0;
+        first_.reset();
+    }
+
+    // sites, which the sweep in progress still refers to from the beachline
+    template< typename F >
+    void for_each_front_site(F && f) const
+    {
+        if (pushed_ == 1) {
+            f(*first_);
+        }
+        for (const auto & ep : endpoints_) {
+            f(ep.k.l);
+            f(ep.k.r);
+        }
+    }
+
     template< typename iterator >
     void operator () (iterator l, const iterator r)
     {
         static_assert(std::is_base_of< std::forward_iterator_tag, typename std::iterator_traits< iterator >::iterator_category >::value,
                       "multipass guarantee required");
         assert(std::is_sorted(l, r));
-        assert(endpoints_.empty());
-        assert(vertices_.empty());
-        assert(edges_.empty());
+        assert(pushed_ == 0);
         if (l == r) {
             return;
         }
-        const iterator ll = l;
-        if (++l == r) {
-            return;
-        }
-        add_cell(ll, l);
-        while (++l != r) {
-            if (process_events(l, r)) {
-                begin_cell(l);
-            }
-        }
-        while (!events_.empty()) {
-            const pevent ev = std::begin(events_);
-            const auto & event_ = *ev;
-            finish_cells(ev, event_.k, event_.v, r, r);
+        reserve(size_type(std::distance(l, r)));
+        for (; l != r; ++l) {
+            push(l);
         }
-        //assert(std::is_sorted(std::begin(vertices_), nv, less_)); // almost true
-        assert(rev == std::begin(rays_));
-        assert(check_last_endpoints());
-        endpoints_.clear();
+        finish();
     }
 
     void clear()
     {
-        assert(rev == std::begin(rays_));
+        assert(rev == rays_.begin());
         assert(endpoints_.empty());
         assert(events_.empty());
         vertices_.clear();
         edges_.clear();
+        clear_slots();
+        statistics_.clear();
+    }
+
+    void shrink_to_fit()
+    {
+        clear();
+        const auto release = [&] (auto & container) { container = std::remove_reference_t< decltype(container) >{allocator_}; };
+        release(vertices_);
+        release(edges_);
+        release(vertex_numbers_);
+        release(vertex_references_);
+        release(free_vertices_);
+        release(free_edges_);
+        release(edge_rays_);
+        release(last_edges_);
+        endpoints_.clear();
+        finger_ = nep;
+        events_.clear();
+        rays_.clear();
+        rays_.shrink_to_fit();
+        rev = nray;
     }
 
 };
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <utility>
+#include <algorithm>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+
+#include <cassert>
+#include <cstddef>
+
+// fixed set of workers, the calling thread takes part in every job as a worker #0
+struct thread_pool
+{
+
+    using size_type = std::size_t;
+
+    explicit
+    thread_pool(const size_type n = std::max(1u, std::thread::hardware_concurrency()))
+    {
+        assert(0 < n);
+        workers_.reserve(n - 1);
+        for (size_type w = 1; w < n; ++w) {
+            workers_.emplace_back([this, w] { work(w); });
+        }
+    }
+
+    thread_pool(const thread_pool &) = delete;
+    thread_pool(thread_pool &&) = delete;
+    void operator = (const thread_pool &) = delete;
+    void operator = (thread_pool &&) = delete;
+
+    ~thread_pool()
+    {
+        {
+            const std::lock_guard< std::mutex > lock_{mutex_};
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (std::thread & worker_ : workers_) {
+            worker_.join();
+        }
+    }
+
+    size_type size() const noexcept { return workers_.size() + 1; }
+
+    // calls f(i, worker) for every i in [0, n), each index is taken by the first free worker
+    // the first exception thrown by f is rethrown after all the workers are done
+    template< typename F >
+    void parallel_for(const size_type n, F && f)
+    {
+        std::atomic< size_type > next{0};
+        const auto job_ = [&] (const size_type worker)
+        {
+            for (size_type i = next.fetch_add(1, std::memory_order_relaxed); i < n; i = next.fetch_add(1, std::memory_order_relaxed)) {
+                f(i, worker);
+            }
+        };
+        if ((n < 2) || workers_.empty()) {
+            job_(0);
+        } else {
+            run(job_);
+        }
+    }
+
+private :
+
+    using invoke = void (*)(const void * job, size_type worker);
+
+    std::vector< std::thread > workers_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+
+    const void * job_ = nullptr;
+    invoke invoke_ = nullptr;
+    size_type generation_ = 0;
+    size_type busy_ = 0;
+    bool stop_ = false;
+    std::exception_ptr error_;
+
+    template< typename J >
+    void run(const J & job)
+    {
+        {
+            const std::lock_guard< std::mutex > lock_{mutex_};
+            assert(!job_); // nested jobs are not supported
+            job_ = &job;
+            invoke_ = [] (const void * j, const size_type worker) { (*static_cast< const J * >(j))(worker); };
+            ++generation_;
+            busy_ = workers_.size();
+        }
+        wake_.notify_all();
+        try {
+            job(0);
+        } catch (...) {
+            const std::lock_guard< std::mutex > lock_{mutex_};
+            if (!error_) {
+                error_ = std::current_exception();
+            }
+        }
+        std::unique_lock< std::mutex > lock_{mutex_};
+        done_.wait(lock_, [&] { return (busy_ == 0); });
+        job_ = nullptr;
+        if (error_) {
+            std::rethrow_exception(std::exchange(error_, nullptr));
+        }
+    }
+
+    void work(const size_type worker)
+    {
+        size_type generation = 0;
+        for (;;) {
+            const void * job = nullptr;
+            invoke invoke_job = nullptr;
+            {
+                std::unique_lock< std::mutex > lock_{mutex_};
+                wake_.wait(lock_, [&] { return stop_ || (generation != generation_); });
+                if (stop_) {
+                    return;
+                }
+                generation = generation_;
+                job = job_;
+                invoke_job = invoke_;
+            }
+            try {
+                invoke_job(job, worker);
+            } catch (...) {
+                const std::lock_guard< std::mutex > lock_{mutex_};
+                if (!error_) {
+                    error_ = std::current_exception();
+                }
+            }
+            const std::lock_guard< std::mutex > lock_{mutex_};
+            if (--busy_ == 0) {
+                done_.notify_one();
+            }
+        }
+    }
+
+};
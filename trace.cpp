@@ -0,0 +1,347 @@
+#include "sweep_trace.hpp"
+#include "site_sort.hpp"
+#include "voronoi.hpp"
+
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <vector>
+#include <string>
+#include <ostream>
+#include <iostream>
+#include <iomanip>
+#include <exception>
+
+#include <cassert>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+// recording and replay of traces of sweeps (see sweep_trace.hpp)
+// sweep: sites of a text or binary site file are sorted and swept with sweep_trace::ring, the trace is written at the end
+// or as soon as the sweep is aborted (e.g. by the check of precision in begin_cell of a debug build)
+// replay: records are binned by the position of the sweep (events are at the position, where they are created or disabled),
+// width of the beachline, depth of the queue and event churn (created and disabled events per site) are charted against x,
+// the bins with the most churn and the widest beachline, sites, which fall onto several endpoints, and the last records are listed
+// usage: sweepline_trace sweep SITES TRACE [--capacity N] [--eps E]
+//        sweepline_trace replay TRACE [--bins N] [--top K] [--tail K] [--format text|gnuplot]
+
+namespace
+{
+
+using value_type = double;
+using point = plane_point< value_type >;
+using size_type = std::size_t;
+using site = const point *;
+using sweepline_type = sweepline< site, point, value_type, tree_event_queue, sweep_trace::ring >;
+using sweep_trace::kind;
+using sweep_trace::record;
+
+constexpr const char * kind_names[] = {"append", "prepend", "middle", "on_edge", "created", "joined", "disabled", "finished"};
+constexpr size_type kinds = std::size(kind_names);
+
+const char * kind_name(const kind kind_)
+{
+    const auto k = size_type(kind_);
+    return (k < kinds) ? kind_names[k] : "unknown";
+}
+
+bool is_site(const kind kind_)
+{
+    return kind_ <= kind::on_edge;
+}
+
+int sweep(const char * const sites_path, const char * const trace_path, const size_type capacity, value_type eps)
+{
+    const site_file::mapped_file file_{sites_path};
+    std::vector< point > points_;
+    site_file::sites< point > sites_ = {nullptr, nullptr};
+    if ((sizeof(site_file::header) <= file_.size()) && (std::memcmp(file_.data(), site_file::header::signature, sizeof site_file::header::signature) == 0)) {
+        sites_ = site_file::get_sites< point >(file_);
+        if ((site_file::get_header(file_).flags & site_file::header::sorted) == 0) {
+            points_.assign(std::cbegin(sites_), std::cend(sites_));
+            sites_ = {nullptr, nullptr};
+        }
+    } else if (!site_file::parse(file_.begin(), file_.end(), points_)) {
+        std::cerr << "bad sites: " << sites_path << '\n';
+        return EXIT_FAILURE;
+    }
+    if (!sites_.first) { // sites of a sorted binary file are swept in place
+        std::vector< std::uint32_t > permutation_;
+        site_sort::radix_permutation(std::cbegin(points_), std::cend(points_), permutation_);
+        site_sort::apply_permutation(std::begin(points_), permutation_);
+        sites_ = {points_.data(), points_.data() + points_.size()};
+    }
+    if (!(value_type(0) < eps)) {
+        value_type magnitude{1};
+        for (const point & p : sites_) {
+            using std::abs;
+            magnitude = std::max({magnitude, abs(p.x), abs(p.y)});
+        }
+        eps = sweepline_type::default_eps(magnitude);
+    }
+    sweepline_type sweepline_{eps};
+    sweepline_.statistics_.resize(capacity);
+    sweep_trace::write_on_abort(sweepline_.statistics_, trace_path);
+    sweepline_(sites_.begin(), sites_.end());
+    const auto & ring_ = sweepline_.statistics_;
+    ring_.write(trace_path);
+    std::cout << "sites " << sites_.size() << ", vertices " << sweepline_.vertices_.size() << ", edges " << sweepline_.edges_.size()
+              << ", records " << ring_.size() << " of " << ring_.total() << '\n';
+    return EXIT_SUCCESS;
+}
+
+struct bin
+{
+
+    size_type counts[kinds] = {};
+    size_type endpoints = 0; // maximal ones
+    size_type events = 0;
+
+    size_type sites() const
+    {
+        return std::accumulate(counts, counts + size_type(kind::created), size_type(0));
+    }
+
+    size_type churn() const
+    {
+        return counts[size_type(kind::created)] + counts[size_type(kind::disabled)];
+    }
+
+    // created and disabled events per site
+    double churn_rate() const
+    {
+        return double(churn()) / double(std::max(sites(), size_type(1)));
+    }
+
+};
+
+struct options
+{
+
+    size_type bins = 64;
+    size_type top = 8;
+    size_type tail = 16;
+    bool gnuplot = false;
+
+};
+
+void print(std::ostream & out_, const record & record_)
+{
+    out_ << std::setw(10) << kind_name(record_.kind_) << ' ' << std::setw(24) << record_.x << ' ' << std::setw(24) << record_.y
+         << ' ' << std::setw(6) << record_.size << ' ' << std::setw(10) << record_.endpoints << ' ' << std::setw(10) << record_.events << '\n';
+}
+
+int replay(const char * const trace_path, const options & _options)
+{
+    const site_file::mapped_file file_{trace_path};
+    const auto & header_ = sweep_trace::get_header(file_);
+    const auto records_ = sweep_trace::get_records(file_);
+    std::ostream & out_ = std::cout;
+    out_.precision(std::numeric_limits< value_type >::digits10 + 1);
+    if (records_.size() == 0) {
+        out_ << "no records\n";
+        return EXIT_SUCCESS;
+    }
+    // position of the sweep for every record
+    std::vector< double > positions_;
+    positions_.reserve(records_.size());
+    double x = records_.first->x;
+    for (const record & record_ : records_) {
+        if (is_site(record_.kind_) || (record_.kind_ == kind::finished)) {
+            x = record_.x;
+        }
+        positions_.push_back(x);
+    }
+    // bins are over the range of sites: events finished after the last site (they lie far away) fall into the last bin
+    double xmin = std::numeric_limits< double >::infinity(), xmax = -xmin;
+    for (const record & record_ : records_) {
+        if (is_site(record_.kind_)) {
+            xmin = std::min(xmin, record_.x);
+            xmax = std::max(xmax, record_.x);
+        }
+    }
+    if (xmax < xmin) { // sites are overwritten
+        xmin = *std::min_element(std::cbegin(positions_), std::cend(positions_));
+        xmax = *std::max_element(std::cbegin(positions_), std::cend(positions_));
+    }
+    const double x0 = xmin, width = xmax - xmin;
+    const size_type bins = std::max(_options.bins, size_type(1));
+    const auto bin_of = [&] (const double position) -> size_type
+    {
+        if (!(0.0 < width) || !(x0 < position)) {
+            return 0;
+        }
+        return std::min(bins - 1, size_type((position - x0) / width * double(bins)));
+    };
+    const auto bin_x = [&] (const size_type b) { return x0 + width * double(b) / double(bins); };
+    std::vector< bin > bins_(bins);
+    bin total_;
+    const record * widest = records_.first;
+    const record * deepest = records_.first;
+    size_type i = 0;
+    for (const record & record_ : records_) {
+        bin & bin_ = bins_[bin_of(positions_[i++])];
+        const auto k = size_type(record_.kind_);
+        if (!(k < kinds)) {
+            throw std::runtime_error{"trace file: unknown kind of a record"};
+        }
+        ++bin_.counts[k];
+        ++total_.counts[k];
+        bin_.endpoints = std::max(bin_.endpoints, size_type(record_.endpoints));
+        bin_.events = std::max(bin_.events, size_type(record_.events));
+        if (widest->endpoints < record_.endpoints) {
+            widest = &record_;
+        }
+        if (deepest->events < record_.events) {
+            deepest = &record_;
+        }
+    }
+    if (_options.gnuplot) {
+        out_ << "$trace << EOD\n";
+        for (size_type b = 0; b < bins; ++b) {
+            const bin & bin_ = bins_[b];
+            out_ << bin_x(b) << ' ' << bin_.sites() << ' ' << bin_.churn() << ' ' << bin_.churn_rate() << ' ' << bin_.endpoints << ' ' << bin_.events << '\n';
+        }
+        out_ << "EOD\n"
+                "set xlabel 'x'\n"
+                "set ylabel 'endpoints, events'\n"
+                "set y2label 'created and disabled events per site'\n"
+                "set ytics nomirror\n"
+                "set y2tics\n"
+                "set key top left\n"
+                "plot $trace using 1:5 with steps title 'beachline', "
+                "$trace using 1:6 with steps title 'queue', "
+                "$trace using 1:4 axes x1y2 with steps title 'churn'\n";
+        return EXIT_SUCCESS;
+    }
+    out_ << "records " << records_.size() << " of " << header_.total;
+    if (records_.size() < header_.total) {
+        out_ << " (the oldest " << (header_.total - records_.size()) << " are overwritten)";
+    }
+    out_ << '\n';
+    for (size_type k = 0; k < kinds; ++k) {
+        out_ << std::setw(10) << kind_names[k] << ' ' << total_.counts[k] << '\n';
+    }
+    const size_type finished = total_.counts[size_type(kind::finished)];
+    if (0 < finished) {
+        size_type rays = 0;
+        for (const record & record_ : records_) {
+            if (record_.kind_ == kind::finished) {
+                rays += record_.size;
+            }
+        }
+        out_ << "rays per finished bundle " << (double(rays) / double(finished)) << '\n';
+    }
+    out_ << "churn " << total_.churn_rate() << " created and disabled events per site\n"
+         << "widest beachline " << widest->endpoints << " endpoints at x = " << positions_[size_type(widest - records_.first)] << '\n'
+         << "deepest queue " << deepest->events << " events at x = " << positions_[size_type(deepest - records_.first)] << '\n';
+    constexpr size_type bar = 40;
+    const size_type max_endpoints = std::max(size_type(widest->endpoints), size_type(1));
+    out_ << '\n' << std::setw(24) << "x" << std::setw(10) << "sites" << std::setw(10) << "churn"
+         << std::setw(10) << "endpoints" << std::setw(10) << "events" << "  beachline\n";
+    for (size_type b = 0; b < bins; ++b) {
+        const bin & bin_ = bins_[b];
+        out_ << std::setw(24) << bin_x(b) << std::setw(10) << bin_.sites() << std::setw(10) << std::setprecision(3) << bin_.churn_rate()
+             << std::setprecision(std::numeric_limits< value_type >::digits10 + 1)
+             << std::setw(10) << bin_.endpoints << std::setw(10) << bin_.events << "  " << std::string(bin_.endpoints * bar / max_endpoints, '#') << '\n';
+    }
+    std::vector< size_type > order_(bins);
+    std::iota(std::begin(order_), std::end(order_), size_type(0));
+    const auto hotspots = [&] (const char * const title, const auto & less)
+    {
+        const size_type top = std::min(_options.top, bins);
+        std::partial_sort(std::begin(order_), std::next(std::begin(order_), std::ptrdiff_t(top)), std::end(order_), less);
+        out_ << '\n' << title << '\n';
+        for (size_type j = 0; j < top; ++j) {
+            const size_type b = order_[j];
+            const bin & bin_ = bins_[b];
+            out_ << "  [" << bin_x(b) << ", " << bin_x(b + 1) << "): " << bin_.sites() << " sites, "
+                 << bin_.churn() << " created and disabled events, " << bin_.endpoints << " endpoints\n";
+        }
+    };
+    hotspots("hotspots by churn:", [&] (const size_type l, const size_type r) { return bins_[r].churn_rate() < bins_[l].churn_rate(); });
+    hotspots("hotspots by beachline:", [&] (const size_type l, const size_type r) { return bins_[r].endpoints < bins_[l].endpoints; });
+    size_type ambiguous = 0;
+    for (const record & record_ : records_) {
+        if ((record_.kind_ == kind::on_edge) && (record_.size != 1)) {
+            if (ambiguous++ == 0) {
+                out_ << "\nsites on several endpoints (problem with precision):\n";
+            }
+            if (ambiguous <= _options.tail) {
+                print(out_, record_);
+            }
+        }
+    }
+    const size_type tail = std::min(_options.tail, records_.size());
+    out_ << "\nlast " << tail << " records:\n"
+         << std::setw(10) << "kind" << ' ' << std::setw(24) << "x" << ' ' << std::setw(24) << "y"
+         << ' ' << std::setw(6) << "size" << ' ' << std::setw(10) << "endpoints" << ' ' << std::setw(10) << "events" << '\n';
+    std::for_each(std::prev(records_.end(), std::ptrdiff_t(tail)), records_.end(), [&] (const record & record_) { print(out_, record_); });
+    return EXIT_SUCCESS;
+}
+
+int usage(const char * const name)
+{
+    std::cerr << "usage: " << name << " sweep SITES TRACE [--capacity N] [--eps E]\n"
+              << "       " << name << " replay TRACE [--bins N] [--top K] [--tail K] [--format text|gnuplot]\n";
+    return EXIT_FAILURE;
+}
+
+}
+
+int main(int argc, char * argv[])
+{
+    if (argc < 3) {
+        return usage(argv[0]);
+    }
+    const bool recording = (std::strcmp(argv[1], "sweep") == 0);
+    if (!recording && (std::strcmp(argv[1], "replay") != 0)) {
+        return usage(argv[0]);
+    }
+    int i = recording ? 4 : 3;
+    if (argc < i) {
+        return usage(argv[0]);
+    }
+    size_type capacity = size_type(1) << 24;
+    value_type eps{0};
+    options options_;
+    for (; i < argc; ++i) {
+        if (!(i + 1 < argc)) {
+            return usage(argv[0]);
+        }
+        const char * const name = argv[i];
+        const char * const value = argv[++i];
+        const auto number = [&] { return size_type(std::strtoull(value, nullptr, 10)); };
+        if (recording && (std::strcmp(name, "--capacity") == 0)) {
+            capacity = number();
+        } else if (recording && (std::strcmp(name, "--eps") == 0)) {
+            eps = std::strtod(value, nullptr);
+        } else if (!recording && (std::strcmp(name, "--bins") == 0)) {
+            options_.bins = number();
+        } else if (!recording && (std::strcmp(name, "--top") == 0)) {
+            options_.top = number();
+        } else if (!recording && (std::strcmp(name, "--tail") == 0)) {
+            options_.tail = number();
+        } else if (!recording && (std::strcmp(name, "--format") == 0)) {
+            if (std::strcmp(value, "gnuplot") == 0) {
+                options_.gnuplot = true;
+            } else if (std::strcmp(value, "text") == 0) {
+                options_.gnuplot = false;
+            } else {
+                return usage(argv[0]);
+            }
+        } else {
+            return usage(argv[0]);
+        }
+    }
+    try {
+        return recording ? sweep(argv[2], argv[3], capacity, eps) : replay(argv[2], options_);
+    } catch (const std::exception & e) {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+}